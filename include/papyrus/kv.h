@@ -36,6 +36,25 @@ struct _papyruskv_pos_t {
 };
 typedef struct _papyruskv_pos_t papyruskv_pos_t;
 
+typedef struct _papyruskv_view_t* papyruskv_view_t;
+
+typedef struct {
+    size_t capacity;
+    size_t bytes;
+    size_t entries;
+    size_t hits;
+    size_t misses;
+    size_t rejected;
+    size_t evicted;
+} papyruskv_cache_stat_t;
+
+typedef struct {
+    size_t hits;
+    size_t misses;
+    size_t large;
+    size_t frees;
+} papyruskv_pool_stat_t;
+
 typedef int (*papyruskv_hash_fn_t)(const char* key, size_t keylen, size_t nranks);
 typedef int (*papyruskv_update_fn_t)(const char* key, size_t keylen, char** val, size_t* vallen, void* userin, size_t userinlen, void* userout, size_t useroutlen);
 
@@ -50,8 +69,13 @@ extern int papyruskv_finalize();
 extern int papyruskv_open(const char* name, int flags, papyruskv_option_t* opt, int* db);
 extern int papyruskv_close(int db);
 extern int papyruskv_put(int db, const char* key, size_t keylen, const char* val, size_t vallen);
+extern int papyruskv_put_batch(int db, size_t n, const char** keys, const size_t* keylens, const char** vals, const size_t* vallens);
 extern int papyruskv_get(int db, const char* key, size_t keylen, char** val, size_t* vallen);
 extern int papyruskv_get_pos(int db, const char* key, size_t keylen, char** val, size_t* vallen, papyruskv_pos_t* pos);
+extern int papyruskv_iget(int db, const char* key, size_t keylen, char** val, size_t* vallen, int* event);
+extern int papyruskv_get_batch(int db, size_t n, const char** keys, const size_t* keylens, char** vals, size_t* vallens, int* rets);
+extern int papyruskv_get_view(int db, const char* key, size_t keylen, const char** val, size_t* vallen, papyruskv_view_t* view);
+extern int papyruskv_release_view(int db, papyruskv_view_t view);
 extern int papyruskv_delete(int db, const char* key, size_t keylen);
 extern int papyruskv_free(char** val);
 extern int papyruskv_fence(int db, int level);
@@ -64,10 +88,14 @@ extern int papyruskv_destroy(int db, int* event);
 extern int papyruskv_checkpoint(int db, const char* path, int* event);
 extern int papyruskv_restart(const char* path, const char* name, int flags, papyruskv_option_t* opt, int* db, int* event);
 extern int papyruskv_wait(int db, int event);
+extern int papyruskv_test(int db, int event, int* flag);
+extern int papyruskv_cache_stat(int db, papyruskv_cache_stat_t* local, papyruskv_cache_stat_t* remote);
+extern int papyruskv_pool_stat(papyruskv_pool_stat_t* stat);
 
 extern int papyruskv_hash(int db, papyruskv_hash_fn_t hfn);
 extern int papyruskv_iter_local(int db, papyruskv_iter_t* iter);
 extern int papyruskv_iter_next(int db, papyruskv_iter_t* iter);
+extern int papyruskv_iter_free(int db, papyruskv_iter_t* iter);
 extern int papyruskv_register_update(int db, int fnid, papyruskv_update_fn_t ufn);
 extern int papyruskv_update(int db, const char* key, size_t keylen, papyruskv_pos_t* pos, int fnid, void* userin, size_t userinlen, void* userout, size_t useroutlen);
 
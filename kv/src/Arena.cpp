@@ -0,0 +1,70 @@
+#include "Arena.h"
+#include "Debug.h"
+#include <stdlib.h>
+
+#define PAPYRUSKV_ARENA_ALIGN   0x10
+
+namespace papyruskv {
+
+Arena::Arena(size_t block_size) {
+    current_ = NULL;
+    block_size_ = block_size;
+    usage_ = 0UL;
+    pthread_mutex_init(&mutex_, NULL);
+}
+
+Arena::~Arena() {
+    for (auto it = blocks_.begin(); it != blocks_.end(); ++it) {
+        free((*it)->base);
+        delete *it;
+    }
+    pthread_mutex_destroy(&mutex_);
+}
+
+char* Arena::Allocate(size_t size) {
+    size = (size + PAPYRUSKV_ARENA_ALIGN - 1) & ~((size_t) PAPYRUSKV_ARENA_ALIGN - 1);
+    Block* block = __atomic_load_n(&current_, __ATOMIC_ACQUIRE);
+    if (block) {
+        size_t off = __atomic_fetch_add(&block->off, size, __ATOMIC_RELAXED);
+        if (off + size <= block->size) return block->base + off;
+    }
+    return AllocateFallback(block, size);
+}
+
+char* Arena::AllocateFallback(Block* block, size_t size) {
+    pthread_mutex_lock(&mutex_);
+    char* ptr;
+    if (size > block_size_ / 4) {
+        // large objects get their own block so the current one is not wasted
+        ptr = NewBlock(size)->base;
+    } else {
+        Block* current = current_;
+        if (current == block || current == NULL) {
+            current = NewBlock(block_size_);
+            __atomic_store_n(&current_, current, __ATOMIC_RELEASE);
+        }
+        size_t off = __atomic_fetch_add(&current->off, size, __ATOMIC_RELAXED);
+        if (off + size > current->size) {
+            current = NewBlock(block_size_);
+            current->off = size;
+            off = 0UL;
+            __atomic_store_n(&current_, current, __ATOMIC_RELEASE);
+        }
+        ptr = current->base + off;
+    }
+    pthread_mutex_unlock(&mutex_);
+    return ptr;
+}
+
+Arena::Block* Arena::NewBlock(size_t size) {
+    Block* block = new Block;
+    if (posix_memalign((void**) &block->base, PAPYRUSKV_ARENA_ALIGN, size) != 0)
+        _error("cannot alloc arena block[%lu]", size);
+    block->off = 0UL;
+    block->size = size;
+    blocks_.push_back(block);
+    usage_ += size;
+    return block;
+}
+
+} /* namespace papyruskv */
@@ -0,0 +1,42 @@
+#ifndef PAPYRUS_KV_SRC_ARENA_H
+#define PAPYRUS_KV_SRC_ARENA_H
+
+#include <stddef.h>
+#include <pthread.h>
+#include <vector>
+#include "Define.h"
+
+namespace papyruskv {
+
+// Thread-safe bump allocator. Memory is only reclaimed when the arena is
+// destroyed, all blocks at once.
+class Arena {
+public:
+    Arena(size_t block_size = PAPYRUSKV_ARENA_BLOCK);
+    ~Arena();
+
+    char* Allocate(size_t size);
+
+    size_t usage() const { return usage_; }
+
+private:
+    struct Block {
+        char* base;
+        size_t off;
+        size_t size;
+    };
+
+    Block* NewBlock(size_t size);
+    char* AllocateFallback(Block* block, size_t size);
+
+private:
+    Block* current_;
+    size_t block_size_;
+    size_t usage_;
+    std::vector<Block*> blocks_;
+    pthread_mutex_t mutex_;
+};
+
+} /* namespace papyruskv */
+
+#endif /* PAPYRUS_KV_SRC_ARENA_H */
@@ -0,0 +1,149 @@
+#include "Block.h"
+#include "Debug.h"
+#include "Utils.h"
+#include <string.h>
+
+namespace papyruskv {
+
+static void PutVarint(std::string* dst, uint64_t v) {
+    unsigned char buf[10];
+    int n = 0;
+    while (v >= 0x80) {
+        buf[n++] = (unsigned char) (v | 0x80);
+        v >>= 7;
+    }
+    buf[n++] = (unsigned char) v;
+    dst->append((const char*) buf, n);
+}
+
+static const char* GetVarint(const char* p, const char* limit, uint64_t* v) {
+    uint64_t result = 0;
+    for (int shift = 0; shift <= 63 && p < limit; shift += 7) {
+        uint64_t byte = (unsigned char) *p++;
+        result |= (byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            *v = result;
+            return p;
+        }
+    }
+    return NULL;
+}
+
+BlockBuilder::BlockBuilder(int restart_interval) {
+    restart_interval_ = restart_interval;
+    counter_ = 0;
+    restarts_.push_back(0);
+}
+
+BlockBuilder::~BlockBuilder() {
+}
+
+void BlockBuilder::Add(const char* key, size_t keylen, const char* val, size_t vallen, bool tombstone) {
+    size_t shared = 0;
+    if (counter_ < restart_interval_) {
+        size_t min_len = keylen < last_key_.size() ? keylen : last_key_.size();
+        while (shared < min_len && last_key_[shared] == key[shared]) shared++;
+    } else {
+        restarts_.push_back((uint32_t) buffer_.size());
+        counter_ = 0;
+    }
+    PutVarint(&buffer_, shared);
+    PutVarint(&buffer_, keylen - shared);
+    PutVarint(&buffer_, vallen);
+    buffer_.push_back(tombstone ? 1 : 0);
+    buffer_.append(key + shared, keylen - shared);
+    if (vallen > 0) buffer_.append(val, vallen);
+
+    last_key_.assign(key, keylen);
+    counter_++;
+}
+
+const char* BlockBuilder::Finish(size_t* len) {
+    for (size_t i = 0; i < restarts_.size(); i++)
+        buffer_.append((const char*) &restarts_[i], sizeof(uint32_t));
+    uint32_t nrestarts = (uint32_t) restarts_.size();
+    buffer_.append((const char*) &nrestarts, sizeof(uint32_t));
+    *len = buffer_.size();
+    return buffer_.data();
+}
+
+void BlockBuilder::Reset() {
+    buffer_.clear();
+    restarts_.clear();
+    restarts_.push_back(0);
+    counter_ = 0;
+    last_key_.clear();
+}
+
+BlockIterator::BlockIterator(const char* data, size_t size) {
+    data_ = data;
+    limit_ = 0;
+    nrestarts_ = 0;
+    if (size >= sizeof(uint32_t)) {
+        memcpy(&nrestarts_, data + size - sizeof(uint32_t), sizeof(uint32_t));
+        size_t trailer = (nrestarts_ + 1) * sizeof(uint32_t);
+        if (trailer <= size) limit_ = (uint32_t) (size - trailer);
+        else _error("size[%lu] nrestarts[%u]", size, nrestarts_);
+    }
+    First();
+}
+
+BlockIterator::~BlockIterator() {
+}
+
+uint32_t BlockIterator::Restart(uint32_t i) {
+    uint32_t off;
+    memcpy(&off, data_ + limit_ + i * sizeof(uint32_t), sizeof(uint32_t));
+    return off;
+}
+
+bool BlockIterator::Decode(uint32_t off) {
+    const char* p = data_ + off;
+    const char* limit = data_ + limit_;
+    uint64_t shared, unshared, vallen;
+    if ((p = GetVarint(p, limit, &shared)) == NULL ||
+        (p = GetVarint(p, limit, &unshared)) == NULL ||
+        (p = GetVarint(p, limit, &vallen)) == NULL ||
+        p + 1 + unshared + vallen > limit || shared > key_.size()) {
+        _error("corrupted block off[%u] limit[%u]", off, limit_);
+        cur_ = limit_;
+        return false;
+    }
+    tombstone_ = *p++ == 1;
+    key_.resize(shared);
+    key_.append(p, unshared);
+    val_ = p + unshared;
+    vallen_ = vallen;
+    cur_ = off;
+    next_ = (uint32_t) (val_ + vallen - data_);
+    return true;
+}
+
+void BlockIterator::First() {
+    key_.clear();
+    cur_ = limit_;
+    if (limit_ > 0) Decode(0);
+}
+
+void BlockIterator::Next() {
+    if (next_ >= limit_) cur_ = limit_;
+    else Decode(next_);
+}
+
+void BlockIterator::Seek(const char* key, size_t keylen) {
+    if (limit_ == 0) return;
+    uint32_t lo = 0;
+    uint32_t hi = nrestarts_ - 1;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi + 1) / 2;
+        key_.clear();
+        if (!Decode(Restart(mid))) return;
+        if (Utils::Compare(key_.data(), key_.size(), key, keylen) < 0) lo = mid;
+        else hi = mid - 1;
+    }
+    key_.clear();
+    if (!Decode(Restart(lo))) return;
+    while (Valid() && Utils::Compare(key_.data(), key_.size(), key, keylen) < 0) Next();
+}
+
+} /* namespace papyruskv */
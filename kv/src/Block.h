@@ -0,0 +1,72 @@
+#ifndef PAPYRUS_KV_SRC_BLOCK_H
+#define PAPYRUS_KV_SRC_BLOCK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace papyruskv {
+
+/*
+ * A block is a run of sorted entries followed by a restart array:
+ *   entry   := varint shared | varint unshared | varint vallen | uint8 tombstone | key[unshared] | val[vallen]
+ *   trailer := uint32 restarts[n] | uint32 n
+ * Keys at restart points are stored whole (shared == 0).
+ */
+class BlockBuilder {
+public:
+    BlockBuilder(int restart_interval);
+    ~BlockBuilder();
+
+    void Add(const char* key, size_t keylen, const char* val, size_t vallen, bool tombstone);
+    const char* Finish(size_t* len);
+    void Reset();
+
+    bool empty() const { return buffer_.empty(); }
+    size_t size() const { return buffer_.size() + (restarts_.size() + 1) * sizeof(uint32_t); }
+    const std::string& last_key() const { return last_key_; }
+
+private:
+    int restart_interval_;
+    int counter_;
+    std::string buffer_;
+    std::string last_key_;
+    std::vector<uint32_t> restarts_;
+};
+
+class BlockIterator {
+public:
+    BlockIterator(const char* data, size_t size);
+    ~BlockIterator();
+
+    bool Valid() const { return cur_ < limit_; }
+    void First();
+    void Next();
+    void Seek(const char* key, size_t keylen);
+
+    const char* key() const { return key_.data(); }
+    size_t keylen() const { return key_.size(); }
+    const char* val() const { return val_; }
+    size_t vallen() const { return vallen_; }
+    bool tombstone() const { return tombstone_; }
+
+private:
+    bool Decode(uint32_t off);
+    uint32_t Restart(uint32_t i);
+
+private:
+    const char* data_;
+    uint32_t limit_;
+    uint32_t nrestarts_;
+    uint32_t cur_;
+    uint32_t next_;
+    std::string key_;
+    const char* val_;
+    size_t vallen_;
+    bool tombstone_;
+};
+
+} /* namespace papyruskv */
+
+#endif /* PAPYRUS_KV_SRC_BLOCK_H */
@@ -1,60 +1,186 @@
 #include <papyrus/kv.h>
 #include "Bloom.h"
 #include "Debug.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#define PAPYRUSKV_BLOOM_ALIGN               64
 
 namespace papyruskv {
 
-Bloom::Bloom(Hasher* hasher, size_t bitlen) {
+static const uint32_t salts[PAPYRUSKV_BLOOM_BLOCK_K] = {
+    0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+    0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U };
+
+#if defined(__x86_64__)
+__attribute__((target("avx2")))
+static bool MaybeBlockAVX2(const uint32_t* block, uint32_t key) {
+    __m256i salt = _mm256_loadu_si256((const __m256i*) salts);
+    __m256i shift = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32((int) key), salt), 27);
+    __m256i mask = _mm256_sllv_epi32(_mm256_set1_epi32(1), shift);
+    __m256i bits = _mm256_load_si256((const __m256i*) block);
+    return _mm256_testc_si256(bits, mask);
+}
+#endif
+
+Bloom::Bloom(Hasher* hasher, double fpr, bool blocked) {
     hasher_ = hasher;
-    bitlen_ = bitlen;
-    len_ = bitlen / 64;
+    fpr_ = fpr > 0.0 && fpr < 1.0 ? fpr : 0.01;
+    blocked_ = blocked;
+#if defined(__x86_64__)
+    avx2_ = __builtin_cpu_supports("avx2");
+#else
+    avx2_ = false;
+#endif
 }
 
 Bloom::~Bloom() {
 
 }
 
-uint64_t* Bloom::Bits(Slice* slices) {
-    uint64_t* bits = new uint64_t[len_];
-    for (size_t i = 0; i < len_; i++) bits[i] = 0ULL;
+size_t Bloom::HeaderWords(uint32_t magic) {
+    return magic == PAPYRUSKV_BLOOM_MAGIC_BLOCKED ? PAPYRUSKV_BLOOM_ALIGN / sizeof(uint64_t) : sizeof(bloom_header_t) / sizeof(uint64_t);
+}
+
+uint64_t* Bloom::Alloc(uint64_t count, size_t* bitslen) {
+    if (count == 0) count = 1;
+    double ln2 = log(2.0);
+    uint64_t nbits = (uint64_t) ceil(-(double) count * log(fpr_) / (ln2 * ln2));
+    uint32_t magic = blocked_ ? PAPYRUSKV_BLOOM_MAGIC_BLOCKED : PAPYRUSKV_BLOOM_MAGIC;
+    uint32_t k = PAPYRUSKV_BLOOM_BLOCK_K;
+    if (blocked_) nbits = (nbits + 255) / 256 * 256;
+    else {
+        nbits = (nbits + 63) / 64 * 64;
+        k = (uint32_t) round((double) nbits / count * ln2);
+        if (k < 1) k = 1;
+        if (k > PAPYRUSKV_BLOOM_MAX_K) k = PAPYRUSKV_BLOOM_MAX_K;
+    }
 
-    for (Slice* slice = slices; slice; slice = slice->next()) {
-        uint64_t hash1 = hasher_->djb2(slice->key(), slice->keylen());
-        uint64_t hash2 = hasher_->MurmurHash2(slice->key(), slice->keylen());
-        uint64_t sha1 = hash1 % bitlen_;
-        uint64_t sha2 = hash2 % bitlen_;
-        uint64_t idx1 = sha1 / 64;
-        uint64_t idx2 = sha2 / 64;
-        uint64_t off1 = sha1 % 64;
-        uint64_t off2 = sha2 % 64;
-        uint64_t bit1 = 1ULL << off1;
-        uint64_t bit2 = 1ULL << off2;
-        bits[idx1] |= bit1;
-        bits[idx2] |= bit2;
-        _trace("hash1[0x%lx] hash2[0x%lx] sha1[%lu] sha2[%lu] idx1[%lu] idx2[%lu] off1[%lu] off2[%lu] bits1[%lx] bits2[%lx]", hash1, hash2, sha1, sha2, idx1, idx2, off1, off2, bits[idx1], bits[idx2]);
+    *bitslen = HeaderWords(magic) + nbits / 64;
+    uint64_t* bits = NULL;
+    if (posix_memalign((void**) &bits, PAPYRUSKV_BLOOM_ALIGN, *bitslen * sizeof(uint64_t)) != 0) {
+        _error("bitslen[%lu]", *bitslen);
+        return NULL;
     }
+    memset(bits, 0, *bitslen * sizeof(uint64_t));
+    bloom_header_t* header = (bloom_header_t*) bits;
+    header->magic = magic;
+    header->k = k;
+    header->nbits = nbits;
+    _trace("count[%lu] fpr[%lf] nbits[%lu] k[%u] blocked[%d]", count, fpr_, nbits, k, blocked_);
     return bits;
 }
 
+void Bloom::Add(uint64_t* bits, const char* key, size_t keylen) {
+    bloom_header_t* header = (bloom_header_t*) bits;
+    uint64_t h = hasher_->MurmurHash2(key, keylen);
+    if (header->magic == PAPYRUSKV_BLOOM_MAGIC_BLOCKED) return AddBlocked(bits, h);
+
+    uint64_t* words = bits + HeaderWords(header->magic);
+    uint64_t delta = (h >> 33) | (h << 31);
+    for (uint32_t i = 0; i < header->k; i++) {
+        uint64_t bit = h % header->nbits;
+        words[bit / 64] |= 1ULL << (bit % 64);
+        h += delta;
+    }
+}
+
+void Bloom::AddBlocked(uint64_t* bits, uint64_t h) {
+    bloom_header_t* header = (bloom_header_t*) bits;
+    uint64_t nblocks = header->nbits / 256;
+    uint32_t* block = (uint32_t*) (bits + HeaderWords(header->magic)) + ((h >> 32) * nblocks >> 32) * PAPYRUSKV_BLOOM_BLOCK_K;
+    uint32_t key = (uint32_t) h;
+    for (int i = 0; i < PAPYRUSKV_BLOOM_BLOCK_K; i++)
+        block[i] |= 1U << ((key * salts[i]) >> 27);
+}
+
+bool Bloom::MaybeBlocked(uint64_t* bits, uint64_t h) {
+    bloom_header_t* header = (bloom_header_t*) bits;
+    uint64_t nblocks = header->nbits / 256;
+    const uint32_t* block = (const uint32_t*) (bits + HeaderWords(header->magic)) + ((h >> 32) * nblocks >> 32) * PAPYRUSKV_BLOOM_BLOCK_K;
+    uint32_t key = (uint32_t) h;
+#if defined(__x86_64__)
+    if (avx2_) return MaybeBlockAVX2(block, key);
+#endif
+    for (int i = 0; i < PAPYRUSKV_BLOOM_BLOCK_K; i++)
+        if ((block[i] & (1U << ((key * salts[i]) >> 27))) == 0) return false;
+    return true;
+}
+
 bool Bloom::Maybe(const char* key, size_t keylen, uint64_t* bits, size_t bitslen) {
-    uint64_t hash1 = hasher_->djb2(key, keylen);
-    uint64_t hash2 = hasher_->MurmurHash2(key, keylen);
-    uint64_t sha1 = hash1 % bitlen_;
-    uint64_t sha2 = hash2 % bitlen_;
-    uint64_t idx1 = sha1 / 64;
-    uint64_t idx2 = sha2 / 64;
-    uint64_t off1 = sha1 % 64;
-    uint64_t off2 = sha2 % 64;
-    uint64_t bit1 = 1ULL << off1;
-    uint64_t bit2 = 1ULL << off2;
-    uint64_t bits1 = bits[idx1];
-    uint64_t bits2 = bits[idx2];
-    _trace("key[%s] hash1[0x%lx] hash2[0x%lx] sha1[%lu] sha2[%lu] idx1[%lu] idx2[%lu] off1[%lu] off2[%lu] bits1[%lx] bits2[%lx] bit1[%lx] bit2[%lx]", key, hash1, hash2, sha1, sha2, idx1, idx2, off1, off2, bits1, bits2, bit1, bit2);
-    if (idx1 >= bitslen || idx2 >= bitslen) {
-        _error("bitslen[%lu] idx1[%lu] idx2[%lu]", bitslen, idx1, idx2);
+    bloom_header_t* header = (bloom_header_t*) bits;
+    uint64_t* words = bits + HeaderWords(header->magic);
+    if (bitslen < HeaderWords(header->magic) + header->nbits / 64) {
+        _error("bitslen[%lu] nbits[%lu]", bitslen, header->nbits);
+        return true;
+    }
+    if (header->magic == PAPYRUSKV_BLOOM_MAGIC_BLOCKED)
+        return MaybeBlocked(bits, hasher_->MurmurHash2(key, keylen));
+    if (header->k == 0) {
+        uint64_t sha1 = hasher_->djb2(key, keylen) % header->nbits;
+        uint64_t sha2 = hasher_->MurmurHash2(key, keylen) % header->nbits;
+        _trace("key[%s] sha1[%lu] sha2[%lu] nbits[%lu]", key, sha1, sha2, header->nbits);
+        return (words[sha1 / 64] & (1ULL << (sha1 % 64))) && (words[sha2 / 64] & (1ULL << (sha2 % 64)));
+    }
+    uint64_t h = hasher_->MurmurHash2(key, keylen);
+    uint64_t delta = (h >> 33) | (h << 31);
+    for (uint32_t i = 0; i < header->k; i++) {
+        uint64_t bit = h % header->nbits;
+        if ((words[bit / 64] & (1ULL << (bit % 64))) == 0) return false;
+        h += delta;
+    }
+    return true;
+}
+
+uint64_t* Bloom::Read(int fd, size_t* bitslen) {
+    off_t size = lseek(fd, 0, SEEK_END);
+    if (size < (off_t) sizeof(uint64_t) || size % sizeof(uint64_t)) {
+        _error("size[%ld]", size);
+        return NULL;
+    }
+    size_t words = size / sizeof(uint64_t);
+    bloom_header_t header;
+    ssize_t ssret = pread(fd, &header, sizeof(header), 0);
+    bool legacy = ssret != sizeof(header) ||
+        (header.magic != PAPYRUSKV_BLOOM_MAGIC && header.magic != PAPYRUSKV_BLOOM_MAGIC_BLOCKED) ||
+        header.nbits == 0 || header.nbits / 64 + HeaderWords(header.magic) != words;
+    size_t header_words = HeaderWords(PAPYRUSKV_BLOOM_MAGIC);
+
+    *bitslen = legacy ? words + header_words : words;
+    uint64_t* bits = NULL;
+    if (posix_memalign((void**) &bits, PAPYRUSKV_BLOOM_ALIGN, *bitslen * sizeof(uint64_t)) != 0) {
+        _error("bitslen[%lu]", *bitslen);
+        return NULL;
+    }
+    char* dst = (char*) (legacy ? bits + header_words : bits);
+    ssret = pread(fd, dst, size, 0);
+    if (ssret != size) {
+        _error("ret[%ld] size[%ld]", ssret, size);
+        free(bits);
+        return NULL;
+    }
+    if (legacy) {
+        bloom_header_t* h = (bloom_header_t*) bits;
+        h->magic = PAPYRUSKV_BLOOM_MAGIC;
+        h->k = 0;
+        h->nbits = words * 64;
+    }
+    return bits;
+}
+
+bool Bloom::Write(int fd, uint64_t* bits, size_t bitslen) {
+    size_t size = bitslen * sizeof(uint64_t);
+    ssize_t ssret = write(fd, bits, size);
+    if (ssret != (ssize_t) size) {
+        _error("ret[%ld] size[%lu]", ssret, size);
         return false;
     }
-    return (bits1 & bit1) == bit1 && (bits2 & bit2) == bit2;
+    return true;
 }
 
 } /* namespace papyruskv */
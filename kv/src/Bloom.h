@@ -4,22 +4,51 @@
 #include "Hasher.h"
 #include "Slice.h"
 
+#define PAPYRUSKV_BLOOM_MAGIC               0x4d4c4250
+#define PAPYRUSKV_BLOOM_MAGIC_BLOCKED       0x424c4250
+#define PAPYRUSKV_BLOOM_MAX_K               30
+#define PAPYRUSKV_BLOOM_BLOCK_K             8
+
 namespace papyruskv {
 
+/*
+ * A filter is kept as one 64-byte aligned array (release with free()):
+ * this header followed by nbits / 64 words. Files written before the header
+ * existed are read back with k == 0, which selects the original two-probe
+ * (djb2 + MurmurHash2) scheme.
+ *
+ * Blocked filters (PAPYRUSKV_BLOOM_MAGIC_BLOCKED) pad the header to a cache
+ * line and split the bits into 256-bit blocks; a key sets one bit in each
+ * 32-bit word of a single block, so a probe touches one cache line.
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t k;
+    uint64_t nbits;
+} bloom_header_t;
+
 class Bloom {
 public:
-    Bloom(Hasher* hasher, size_t bitlen);
+    Bloom(Hasher* hasher, double fpr, bool blocked);
     ~Bloom();
 
-    size_t len() const { return len_; }
-
-    uint64_t* Bits(Slice* slices);
+    uint64_t* Alloc(uint64_t count, size_t* bitslen);
+    void Add(uint64_t* bits, const char* key, size_t keylen);
     bool Maybe(const char* key, size_t keylen, uint64_t* bits, size_t bitslen);
 
+    uint64_t* Read(int fd, size_t* bitslen);
+    bool Write(int fd, uint64_t* bits, size_t bitslen);
+
+private:
+    static size_t HeaderWords(uint32_t magic);
+    void AddBlocked(uint64_t* bits, uint64_t h);
+    bool MaybeBlocked(uint64_t* bits, uint64_t h);
+
 private:
     Hasher* hasher_;
-    size_t bitlen_;
-    size_t len_;
+    double fpr_;
+    bool blocked_;
+    bool avx2_;
 };
 
 } /* namespace papyruskv */
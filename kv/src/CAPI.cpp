@@ -24,6 +24,10 @@ int papyruskv_put(int db, const char* key, size_t keylen, const char* val, size_
     return Platform::GetPlatform()->Put(db, key, keylen, val, vallen);
 }
 
+int papyruskv_put_batch(int db, size_t n, const char** keys, const size_t* keylens, const char** vals, const size_t* vallens) {
+    return Platform::GetPlatform()->PutBatch(db, n, keys, keylens, vals, vallens);
+}
+
 int papyruskv_get(int db, const char* key, size_t keylen, char** val, size_t* vallen) {
     return papyruskv_get_pos(db, key, keylen, val, vallen, NULL);
 }
@@ -32,6 +36,22 @@ int papyruskv_get_pos(int db, const char* key, size_t keylen, char** val, size_t
     return Platform::GetPlatform()->Get(db, key, keylen, val, vallen, pos);
 }
 
+int papyruskv_iget(int db, const char* key, size_t keylen, char** val, size_t* vallen, int* event) {
+    return Platform::GetPlatform()->IGet(db, key, keylen, val, vallen, event);
+}
+
+int papyruskv_get_batch(int db, size_t n, const char** keys, const size_t* keylens, char** vals, size_t* vallens, int* rets) {
+    return Platform::GetPlatform()->GetBatch(db, n, keys, keylens, vals, vallens, rets);
+}
+
+int papyruskv_get_view(int db, const char* key, size_t keylen, const char** val, size_t* vallen, papyruskv_view_t* view) {
+    return Platform::GetPlatform()->GetView(db, key, keylen, val, vallen, view);
+}
+
+int papyruskv_release_view(int db, papyruskv_view_t view) {
+    return Platform::GetPlatform()->ReleaseView(db, view);
+}
+
 int papyruskv_delete(int db, const char* key, size_t keylen) {
     return Platform::GetPlatform()->Delete(db, key, keylen);
 }
@@ -80,6 +100,18 @@ int papyruskv_wait(int db, int event) {
     return Platform::GetPlatform()->Wait(db, event);
 }
 
+int papyruskv_test(int db, int event, int* flag) {
+    return Platform::GetPlatform()->Test(db, event, flag);
+}
+
+int papyruskv_cache_stat(int db, papyruskv_cache_stat_t* local, papyruskv_cache_stat_t* remote) {
+    return Platform::GetPlatform()->CacheStat(db, local, remote);
+}
+
+int papyruskv_pool_stat(papyruskv_pool_stat_t* stat) {
+    return Platform::GetPlatform()->PoolStat(stat);
+}
+
 int papyruskv_hash(int db, papyruskv_hash_fn_t hfn) {
     return Platform::GetPlatform()->Hash(db);
 }
@@ -92,6 +124,10 @@ int papyruskv_iter_next(int db, papyruskv_iter_t* iter) {
     return Platform::GetPlatform()->IterNext(db, iter);
 }
 
+int papyruskv_iter_free(int db, papyruskv_iter_t* iter) {
+    return Platform::GetPlatform()->IterFree(db, iter);
+}
+
 int papyruskv_register_update(int db, int fnid, papyruskv_update_fn_t ufn) {
     return Platform::GetPlatform()->RegisterUpdate(db, fnid, ufn);
 }
@@ -2,111 +2,304 @@
 #include "Cache.h"
 #include "DB.h"
 #include "Debug.h"
+#include "Platform.h"
 #include "Slice.h"
+#include <string.h>
+#include <time.h>
+
+#define PAPYRUSKV_CACHE_BUCKETS 64
+#define PAPYRUSKV_CACHE_SKETCH_ENTRY 256
 
 namespace papyruskv {
 
+/* Bytes an entry really holds: the 16-byte aligned slice buffer, the Slice and
+ * entry headers, and up to two hash bucket slots (tables double at load 1). */
+static size_t Charge(size_t size) {
+    return ((size + 0xf) & ~0xfUL) + sizeof(Slice) + sizeof(cache_entry_t) + 2 * sizeof(cache_entry_t*);
+}
+
+static double Now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1.e-9 * ts.tv_nsec;
+}
+
 Cache::Cache(DB* db, size_t capacity, bool local) {
     db_ = db;
+    hasher_ = db_->hasher();
     capacity_ = capacity;
     local_ = local;
-    size_ = 0UL;
     enable_ = true;
+    clock_ = db_->platform()->enable_cache_clock();
     rank_ = db_->rank();
-    hit_ = 0UL;
-    miss_ = 0UL;
-    pthread_mutex_init(&mutex_, NULL);
+
+    nshards_ = db_->platform()->cache_shards();
+    shard_bits_ = 0;
+    while ((1UL << shard_bits_) < nshards_) shard_bits_++;
+    shard_capacity_ = capacity_ / nshards_;
+
+    shards_ = new cache_shard_t[nshards_];
+    for (size_t i = 0; i < nshards_; i++) {
+        cache_shard_t* shard = shards_ + i;
+        pthread_rwlock_init(&shard->lock, NULL);
+        shard->nbuckets = PAPYRUSKV_CACHE_BUCKETS;
+        shard->buckets = new cache_entry_t*[shard->nbuckets]();
+        shard->head.prev = &shard->head;
+        shard->head.next = &shard->head;
+        shard->hand = NULL;
+        shard->count = 0UL;
+        shard->size = 0UL;
+        shard->capacity = shard_capacity_;
+        shard->hit = 0UL;
+        shard->miss = 0UL;
+        shard->rejected = 0UL;
+        shard->evicted = 0UL;
+        shard->sketch = NULL;
+    }
 }
 
 Cache::~Cache() {
-    pthread_mutex_lock(&mutex_);
-    for (auto it = lru_.begin(); it != lru_.end(); ++it) delete it->second;
-    pthread_mutex_unlock(&mutex_);
-    pthread_mutex_destroy(&mutex_);
+    size_t hit = 0UL;
+    size_t miss = 0UL;
+    size_t rejected = 0UL;
+    for (size_t i = 0; i < nshards_; i++) {
+        cache_shard_t* shard = shards_ + i;
+        Clear(shard);
+        hit += shard->hit;
+        miss += shard->miss;
+        rejected += shard->rejected;
+        if (shard->sketch) delete shard->sketch;
+        delete[] shard->buckets;
+        pthread_rwlock_destroy(&shard->lock);
+    }
+    delete[] shards_;
+
+    if (enable_ && hit + miss > 0) {
+        _trace("[%s] hit[%lu] miss[%lu] hitratio[%lf] rejected[%lu]", local_ ? "local" : "remote" , hit, miss, (double) (hit) / (hit + miss), rejected);
+    }
+}
 
-    if (enable_ && hit_ + miss_ > 0) {
-        _trace("[%s] hit[%lu] miss[%lu] hitratio[%lf]", local_ ? "local" : "remote" , hit_, miss_, (double) (hit_) / (hit_ + miss_));
+void Cache::EnableAdmission(bool enable) {
+    for (size_t i = 0; i < nshards_; i++) {
+        cache_shard_t* shard = shards_ + i;
+        if (enable && shard->sketch == NULL) shard->sketch = new Sketch(shard_capacity_ / PAPYRUSKV_CACHE_SKETCH_ENTRY);
+        else if (!enable && shard->sketch) {
+            delete shard->sketch;
+            shard->sketch = NULL;
+        }
+        /* the sketch is paid for out of the stripe's budget */
+        size_t sketch_size = shard->sketch ? shard->sketch->size() : 0UL;
+        shard->capacity = shard_capacity_ > sketch_size ? shard_capacity_ - sketch_size : 0UL;
     }
 }
 
-void Cache::Put(const char* key, size_t keylen, char* val, size_t vallen, int rank, bool tombstone) {
+void Cache::Put(const char* key, size_t keylen, const char* val, size_t vallen, int rank, bool tombstone, uint64_t epoch, size_t lease) {
     if (!enable_) return;
 
-    pthread_mutex_lock(&mutex_);
-    Invalidate(key, keylen, false);
-
-    Slice* slice = new Slice(key, keylen, val, vallen, rank, tombstone);
-    std::string keystr = std::string(slice->key(), slice->keylen());
-    lru_.push_front(pair_t(keystr, slice));
-    table_[keystr] = lru_.begin();
-    size_ += slice->size();
-
-    if (size_ > capacity_) {
-        auto last = lru_.end();
-        last--;
-        Slice* slice = last->second;
-        table_.erase(last->first);
-        lru_.pop_back();
-        size_ -= slice->size();
-        delete slice;
+    unsigned long hash = hasher_->MurmurHash2(key, keylen);
+    cache_shard_t* shard = Shard(hash);
+    pthread_rwlock_wrlock(&shard->lock);
+    cache_entry_t* old = Find(shard, hash, key, keylen);
+    if (old) Remove(shard, old);
+    else if (!Admit(shard, hash, Charge(keylen + vallen + 1))) {
+        shard->rejected++;
+        pthread_rwlock_unlock(&shard->lock);
+        return;
     }
-    pthread_mutex_unlock(&mutex_);
+
+    cache_entry_t* entry = new cache_entry_t;
+    entry->slice = new Slice(key, keylen, val, vallen, rank, tombstone);
+    entry->charge = Charge(entry->slice->size());
+    entry->hash = hash;
+    entry->epoch = epoch;
+    entry->expire = lease ? Now() + 1.e-6 * lease : 0.0;
+    entry->visited = false;
+    cache_entry_t** bucket = Bucket(shard, hash);
+    entry->hnext = *bucket;
+    *bucket = entry;
+    Link(shard, entry);
+    shard->count++;
+    shard->size += entry->charge;
+
+    if (shard->count > shard->nbuckets) Grow(shard);
+    Evict(shard);
+    pthread_rwlock_unlock(&shard->lock);
 }
 
 int Cache::Get(const char* key, size_t keylen, char** valp, size_t* vallenp) {
+    return Lookup(key, keylen, valp, vallenp, NULL);
+}
+
+int Cache::GetView(const char* key, size_t keylen, View* view) {
+    return Lookup(key, keylen, NULL, NULL, view);
+}
+
+int Cache::Lookup(const char* key, size_t keylen, char** valp, size_t* vallenp, View* view) {
     if (!enable_) return PAPYRUSKV_SLICE_NOT_FOUND;
 
-    pthread_mutex_lock(&mutex_);
-    std::string keystr = std::string(key, keylen);
-    auto it = table_.find(keystr);
-    if (it == table_.end()) {
-        miss_++;
-        pthread_mutex_unlock(&mutex_);
+    unsigned long hash = hasher_->MurmurHash2(key, keylen);
+    cache_shard_t* shard = Shard(hash);
+    if (clock_) pthread_rwlock_rdlock(&shard->lock);
+    else pthread_rwlock_wrlock(&shard->lock);
+    cache_entry_t* entry = Find(shard, hash, key, keylen);
+    if (shard->sketch) shard->sketch->Increment(hash);
+    if (entry == NULL || !Valid(entry)) {
+        __sync_fetch_and_add(&shard->miss, 1);
+        pthread_rwlock_unlock(&shard->lock);
         return PAPYRUSKV_SLICE_NOT_FOUND;
     }
-    hit_++;
-    lru_.splice(lru_.begin(), lru_, it->second);
-    Slice* slice = it->second->second;
-    if (slice->tombstone()) {
-        pthread_mutex_unlock(&mutex_);
-        return PAPYRUSKV_SLICE_TOMBSTONE;
+    __sync_fetch_and_add(&shard->hit, 1);
+    if (clock_) __atomic_store_n(&entry->visited, true, __ATOMIC_RELAXED);
+    else {
+        Unlink(shard, entry);
+        Link(shard, entry);
     }
-    slice->CopyValue(valp, vallenp);
-    pthread_mutex_unlock(&mutex_);
-    return PAPYRUSKV_SLICE_FOUND;
+
+    Slice* slice = entry->slice;
+    int ret = PAPYRUSKV_SLICE_FOUND;
+    if (slice->tombstone()) ret = PAPYRUSKV_SLICE_TOMBSTONE;
+    else if (view) view->Pin(slice);
+    else slice->CopyValue(valp, vallenp);
+    pthread_rwlock_unlock(&shard->lock);
+    return ret;
 }
 
-bool Cache::Invalidate(const char* key, size_t keylen, bool lock) {
+bool Cache::Invalidate(const char* key, size_t keylen) {
     if (!enable_) return false;
 
-    if (lock) pthread_mutex_lock(&mutex_);
-    auto it = table_.find(std::string(key, keylen));
-    if (it == table_.end()) {
-        if (lock) pthread_mutex_unlock(&mutex_);
-        return false;
-    }
-
-    Slice* slice = it->second->second;
-    lru_.erase(it->second);
-    table_.erase(it);
-    size_ -= slice->size();
-    delete slice;
-    if (lock) pthread_mutex_unlock(&mutex_);
+    unsigned long hash = hasher_->MurmurHash2(key, keylen);
+    cache_shard_t* shard = Shard(hash);
+    pthread_rwlock_wrlock(&shard->lock);
+    cache_entry_t* entry = Find(shard, hash, key, keylen);
+    if (entry) Remove(shard, entry);
+    pthread_rwlock_unlock(&shard->lock);
 
-    return true;
+    return entry != NULL;
 }
 
 void Cache::InvalidateAll() {
     if (!enable_) return;
 
-    pthread_mutex_lock(&mutex_);
-    auto it = table_.begin();
-    for (auto it = table_.begin(); it != table_.end(); ++it) {
-        Slice* slice = it->second->second;
-        delete slice;
+    for (size_t i = 0; i < nshards_; i++) {
+        cache_shard_t* shard = shards_ + i;
+        pthread_rwlock_wrlock(&shard->lock);
+        Clear(shard);
+        pthread_rwlock_unlock(&shard->lock);
+    }
+}
+
+void Cache::Stat(papyruskv_cache_stat_t* stat) {
+    memset(stat, 0, sizeof(*stat));
+    stat->capacity = capacity_;
+    for (size_t i = 0; i < nshards_; i++) {
+        cache_shard_t* shard = shards_ + i;
+        pthread_rwlock_rdlock(&shard->lock);
+        stat->bytes += shard->size;
+        stat->entries += shard->count;
+        stat->hits += __atomic_load_n(&shard->hit, __ATOMIC_RELAXED);
+        stat->misses += __atomic_load_n(&shard->miss, __ATOMIC_RELAXED);
+        stat->rejected += shard->rejected;
+        stat->evicted += shard->evicted;
+        pthread_rwlock_unlock(&shard->lock);
+    }
+}
+
+cache_entry_t* Cache::Find(cache_shard_t* shard, unsigned long hash, const char* key, size_t keylen) {
+    cache_entry_t* entry = *Bucket(shard, hash);
+    while (entry && (entry->hash != hash || !entry->slice->Match(key, keylen))) entry = entry->hnext;
+    return entry;
+}
+
+/* A stale lease stays in place until the refetched value replaces it. */
+bool Cache::Valid(cache_entry_t* entry) {
+    if (entry->expire == 0.0) return true;
+    return Now() < entry->expire && db_->epoch(entry->slice->rank()) == entry->epoch;
+}
+
+void Cache::Link(cache_shard_t* shard, cache_entry_t* entry) {
+    entry->prev = &shard->head;
+    entry->next = shard->head.next;
+    shard->head.next->prev = entry;
+    shard->head.next = entry;
+}
+
+void Cache::Unlink(cache_shard_t* shard, cache_entry_t* entry) {
+    if (shard->hand == entry) shard->hand = entry->prev;
+    entry->prev->next = entry->next;
+    entry->next->prev = entry->prev;
+}
+
+void Cache::Remove(cache_shard_t* shard, cache_entry_t* entry) {
+    cache_entry_t** prev = Bucket(shard, entry->hash);
+    while (*prev != entry) prev = &(*prev)->hnext;
+    *prev = entry->hnext;
+    Unlink(shard, entry);
+    shard->count--;
+    shard->size -= entry->charge;
+    Slice::Release(entry->slice);
+    delete entry;
+}
+
+void Cache::Clear(cache_shard_t* shard) {
+    cache_entry_t* entry = shard->head.next;
+    while (entry != &shard->head) {
+        cache_entry_t* next = entry->next;
+        Slice::Release(entry->slice);
+        delete entry;
+        entry = next;
+    }
+    for (size_t i = 0; i < shard->nbuckets; i++) shard->buckets[i] = NULL;
+    shard->head.prev = &shard->head;
+    shard->head.next = &shard->head;
+    shard->hand = NULL;
+    shard->count = 0UL;
+    shard->size = 0UL;
+}
+
+void Cache::Grow(cache_shard_t* shard) {
+    delete[] shard->buckets;
+    shard->nbuckets <<= 1;
+    shard->buckets = new cache_entry_t*[shard->nbuckets]();
+    for (cache_entry_t* entry = shard->head.next; entry != &shard->head; entry = entry->next) {
+        cache_entry_t** bucket = Bucket(shard, entry->hash);
+        entry->hnext = *bucket;
+        *bucket = entry;
+    }
+}
+
+bool Cache::Admit(cache_shard_t* shard, unsigned long hash, size_t size) {
+    Sketch* sketch = shard->sketch;
+    if (sketch == NULL) return true;
+    if (sketch->Aging()) sketch->Age();
+    if (shard->size + size <= shard->capacity) return true;
+    cache_entry_t* victim = Victim(shard);
+    return victim == NULL || sketch->Estimate(hash) > sketch->Estimate(victim->hash);
+}
+
+void Cache::Evict(cache_shard_t* shard) {
+    while (shard->size > shard->capacity) {
+        cache_entry_t* victim = Victim(shard);
+        if (victim == NULL) break;
+        Remove(shard, victim);
+        shard->evicted++;
+    }
+}
+
+cache_entry_t* Cache::Victim(cache_shard_t* shard) {
+    cache_entry_t* head = &shard->head;
+    if (head->prev == head) return NULL;
+    if (!clock_) return head->prev;
+
+    cache_entry_t* entry = shard->hand ? shard->hand : head->prev;
+    while (true) {
+        if (entry == head) entry = entry->prev;
+        else if (entry->visited) {
+            entry->visited = false;
+            entry = entry->prev;
+        } else break;
     }
-    table_.clear();
-    pthread_mutex_unlock(&mutex_);
+    shard->hand = entry;
+    return entry;
 }
 
 } /* namespace papyruskv */
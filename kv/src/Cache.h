@@ -1,47 +1,100 @@
 #ifndef PAPYRUS_KV_SRC_CACHE_H
 #define PAPYRUS_KV_SRC_CACHE_H
 
+#include <papyrus/kv.h>
 #include <pthread.h>
-#include <unordered_map>
-#include <list>
-#include <string>
+#include <stdint.h>
+#include "Sketch.h"
 #include "Slice.h"
+#include "View.h"
 
 namespace papyruskv {
 
 class DB;
+class Hasher;
 
-class Cache {
-public:
+/* Entries point at the cached slice; the key is only stored in the slice.
+ * hash is MurmurHash2 of the key, not the djb2 KeyHash that picks the owner
+ * rank: all keys of a rank agree on KeyHash mod nranks, which would leave
+ * most shards and buckets of its local cache unused.
+ * Leased entries (expire != 0) are only served until the lease runs out or
+ * the owner's epoch known to the DB moves past the one they were read at. */
+typedef struct _cache_entry_t {
+    Slice* slice;
+    size_t charge;
+    unsigned long hash;
+    uint64_t epoch;
+    double expire;
+    struct _cache_entry_t* hnext;
+    struct _cache_entry_t* prev;
+    struct _cache_entry_t* next;
+    bool visited;
+} cache_entry_t;
 
-    typedef std::pair<std::string, Slice*> pair_t;
-    typedef std::list<pair_t>::iterator iter_t;
+/* One lock stripe: a chained hash table plus a recency ring whose head.next is
+ * the newest entry. LRU evicts head.prev; CLOCK sweeps the hand from the tail
+ * and gives visited entries a second chance, so hits never touch the ring.
+ * With TinyLFU admission a new key only displaces the next victim if the
+ * stripe's sketch has seen it more often. */
+typedef struct {
+    pthread_rwlock_t lock;
+    cache_entry_t** buckets;
+    size_t nbuckets;
+    cache_entry_t head;
+    cache_entry_t* hand;
+    size_t count;
+    size_t size;
+    size_t capacity;
+    size_t hit;
+    size_t miss;
+    size_t rejected;
+    size_t evicted;
+    Sketch* sketch;
+} cache_shard_t;
 
+class Cache {
+public:
     Cache(DB* db, size_t capacity, bool local);
     ~Cache();
 
-    void Put(const char* key, size_t keylen, char* val, size_t vallen, int rank, bool tombstone);
+    void Put(const char* key, size_t keylen, const char* val, size_t vallen, int rank, bool tombstone, uint64_t epoch = 0, size_t lease = 0);
     int Get(const char* key, size_t keylen, char** valp, size_t* vallenp);
-    bool Invalidate(const char* key, size_t keylen, bool lock = true);
+    int GetView(const char* key, size_t keylen, View* view);
+    bool Invalidate(const char* key, size_t keylen);
     void InvalidateAll();
+    void Stat(papyruskv_cache_stat_t* stat);
 
     void Enable(bool enable) { enable_ = enable; }
+    void EnableAdmission(bool enable);
+
+private:
+    int Lookup(const char* key, size_t keylen, char** valp, size_t* vallenp, View* view);
+    cache_shard_t* Shard(unsigned long hash) { return shards_ + (hash & (nshards_ - 1)); }
+    cache_entry_t** Bucket(cache_shard_t* shard, unsigned long hash) { return shard->buckets + ((hash >> shard_bits_) & (shard->nbuckets - 1)); }
+    cache_entry_t* Find(cache_shard_t* shard, unsigned long hash, const char* key, size_t keylen);
+    bool Valid(cache_entry_t* entry);
+    void Link(cache_shard_t* shard, cache_entry_t* entry);
+    void Unlink(cache_shard_t* shard, cache_entry_t* entry);
+    void Remove(cache_shard_t* shard, cache_entry_t* entry);
+    void Clear(cache_shard_t* shard);
+    void Grow(cache_shard_t* shard);
+    bool Admit(cache_shard_t* shard, unsigned long hash, size_t size);
+    void Evict(cache_shard_t* shard);
+    cache_entry_t* Victim(cache_shard_t* shard);
 
 private:
     DB* db_;
+    Hasher* hasher_;
     size_t capacity_;
-    size_t size_;
     bool local_;
     bool enable_;
+    bool clock_;
     int rank_;
 
-    size_t hit_;
-    size_t miss_;
-
-    std::list<pair_t> lru_;
-    std::unordered_map<std::string, iter_t> table_;
-
-    pthread_mutex_t mutex_;
+    cache_shard_t* shards_;
+    size_t nshards_;
+    int shard_bits_;
+    size_t shard_capacity_;
 };
 
 } /* namespace papyruskv */
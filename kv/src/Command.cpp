@@ -1,6 +1,7 @@
 #include "Command.h"
 #include "Platform.h"
 #include "Debug.h"
+#include <stdlib.h>
 #include <string.h>
 
 namespace papyruskv {
@@ -9,12 +10,17 @@ Command::Command(int type) {
     cid_ = Platform::NewCID();
     type_ = type;
     status_ = PAPYRUSKV_NONE;
+    ret_ = PAPYRUSKV_OK;
+    mt_ = NULL;
+    block_ = NULL;
+    request_ = MPI_REQUEST_NULL;
 
     pthread_mutex_init(&mutex_complete_, NULL);
     pthread_cond_init(&cond_complete_, NULL);
 }
 
 Command::~Command() {
+    if (type_ == PAPYRUSKV_CMD_GET && block_) free(block_);
     pthread_mutex_destroy(&mutex_complete_);
     pthread_cond_destroy(&cond_complete_);
 }
@@ -44,6 +50,13 @@ void Command::Wait() {
     pthread_mutex_unlock(&mutex_complete_);
 }
 
+bool Command::Test() {
+    pthread_mutex_lock(&mutex_complete_);
+    bool complete = status_ == PAPYRUSKV_COMPLETE;
+    pthread_mutex_unlock(&mutex_complete_);
+    return complete;
+}
+
 Command* Command::Create(int type) {
     return new Command(type);
 }
@@ -66,7 +79,10 @@ Command* Command::CreateGet(DB* db, const char* key, size_t keylen, char** valp,
     Command* cmd = Create(PAPYRUSKV_CMD_GET);
     cmd->db_ = db;
     cmd->dbid_ = db->dbid();
-    cmd->key_ = key;
+    size_t packetlen = PAPYRUSKV_GET_PACKET * sizeof(size_t) + db->get_eager();
+    cmd->block_ = (char*) malloc(packetlen + keylen);
+    memcpy(cmd->block_ + packetlen, key, keylen);
+    cmd->key_ = cmd->block_ + packetlen;
     cmd->keylen_ = keylen;
     cmd->valp_ = valp;
     cmd->vallenp_ = vallenp;
@@ -24,6 +24,7 @@
 
 #define PAPYRUSKV_MPI_TAG_LIMIT         0x200000
 
+#include <mpi.h>
 #include <stdint.h>
 #include <pthread.h>
 #include <sys/types.h>
@@ -44,6 +45,7 @@ public:
     void Complete();
     void Complete(int ret);
     void Wait();
+    bool Test();
 
     unsigned long cid() const { return cid_; }
     int type() const { return type_; }
@@ -52,7 +54,7 @@ public:
     int group() const { return group_; }
     bool sync() const { return sync_; }
     int level() const { return level_; }
-    int tag() const { return cid_ % PAPYRUSKV_MPI_TAG_LIMIT; }
+    int tag() const { return (int) (cid_ % (PAPYRUSKV_MPI_TAG_LIMIT - 1)) + 1; }
 
     DB* db() const { return db_; }
     int dbid() const { return dbid_; }
@@ -72,6 +74,7 @@ public:
     MemTable* mt() const { return mt_; }
     RemoteBuffer* rb() const { return rb_; }
     char* block() const { return block_; }
+    MPI_Request* request() { return &request_; }
 
     SSTable* sstable() const { return sstable_; }
     uint64_t* sids() const { return sids_; }
@@ -114,6 +117,7 @@ private:
     MemTable* mt_;
     RemoteBuffer* rb_;
     char* block_;
+    MPI_Request request_;
 
     SSTable* sstable_;
     uint64_t sid_;
@@ -9,14 +9,19 @@ namespace papyruskv {
 Compactor::Compactor(Platform* platform) {
     platform_ = platform;
     rank_ = platform->rank();
-    queue_ = new LockFreeQueueMS<Command*>(4);
+    queue_ = new LockFreeQueueMS<Command*>(PAPYRUSKV_FLUSH_QUEUE + 1);
+    sem_init(&slots_, 0, PAPYRUSKV_FLUSH_QUEUE);
 }
 
 Compactor::~Compactor() {
+    Stop();
+    sem_destroy(&slots_);
+    delete queue_;
 }
 
 void Compactor::Enqueue(Command* cmd) {
-    while (!queue_->Enqueue(cmd)) {}
+    sem_wait(&slots_);
+    queue_->Enqueue(cmd);
     Invoke();
 }
 
@@ -35,7 +40,10 @@ void Compactor::Run() {
         sem_wait(&sem_);
         if (!running_) break;
         Command* cmd = NULL;
-        while (queue_->Dequeue(&cmd)) Execute(cmd);
+        while (queue_->Dequeue(&cmd)) {
+            sem_post(&slots_);
+            Execute(cmd);
+        }
     }
 }
 
@@ -44,6 +52,7 @@ void Compactor::Execute(Command* cmd) {
     switch (cmd->type()) {
         case PAPYRUSKV_CMD_FLUSH:       ExecuteFlush(cmd);      break;
         case PAPYRUSKV_CMD_LOAD:        ExecuteLoad(cmd);       break;
+        case PAPYRUSKV_CMD_NOP:         cmd->Complete();        break;
         default: _error("not supported command type[0x%x]", cmd->type());
     }
 }
@@ -68,6 +77,8 @@ void Compactor::ExecuteFlush(Command* cmd) {
 
     cmd->Complete();
     if (!cmd->sync()) Command::Release(cmd);
+
+    while (sstable->Compact()) {}
 }
 
 void Compactor::ExecuteLoad(Command* cmd) {
@@ -9,6 +9,10 @@ namespace papyruskv {
 
 class Platform;
 
+/* One flush thread. The platform runs several and a DB always uses the one
+ * its dbid maps to, so flushes, loads and compactions of one DB stay in
+ * order while those of different DBs proceed in parallel. Enqueue blocks
+ * while PAPYRUSKV_FLUSH_QUEUE commands are pending. */
 class Compactor : public Thread {
 public:
     Compactor(Platform* platform);
@@ -28,6 +32,7 @@ private:
 
 private:
     LockFreeQueue<Command*>* queue_;
+    sem_t slots_;
     Platform* platform_;
 
     int rank_;
@@ -24,15 +24,20 @@ DB::DB(unsigned long dbid, const char* name, int flags, papyruskv_option_t* opt,
     group_ = platform->group();
     hasher_ = platform->hasher();
     dispatcher_ = platform->dispatcher();
-    compactor_ = platform->compactor();
+    compactor_ = platform->compactor(dbid_);
     mpi_comm_ = platform->mpi_comm();
     mpi_comm_ext_ = platform->mpi_comm_ext();
     memtable_size_ = platform->memtable_size();
     remote_buf_size_ = platform->remote_buf_size();
     cache_size_ = platform->cache_size();
+    lease_ = platform->enable_cache_remote() ? platform->cache_lease() : 0UL;
+    epoch_ = 0UL;
+    epochs_ = new uint64_t[nranks_]();
 
     keylen_ = opt ? opt->keylen : 0UL;
     vallen_ = opt ? opt->vallen : 0UL;
+    if (vallen_) platform->pool()->SetFixed(vallen_);
+    get_eager_ = vallen_ > platform->get_eager() ? vallen_ : platform->get_eager();
     if (opt) hasher_->set_hash(opt->hash);
     enable_remote_buffer_ = vallen_ > 0UL && vallen_ <= platform->remote_buf_entry_max();
 
@@ -42,13 +47,16 @@ DB::DB(unsigned long dbid, const char* name, int flags, papyruskv_option_t* opt,
     local_cache_ = new Cache(this, cache_size_, true);
     remote_cache_ = new Cache(this, cache_size_, false);
     sstable_ = new SSTable(this, platform->sstable_mode());
+    window_ = platform->enable_rma() ? new Window(this) : NULL;
 
     if (posix_memalign((void**) &big_buffer_, 0x1000, PAPYRUSKV_BIG_BUFFER) != 0) _error("size[%lu]", PAPYRUSKV_BIG_BUFFER);
 
     local_cache_->Enable(platform->enable_cache_local());
     remote_cache_->Enable(platform->enable_cache_remote());
+    local_cache_->EnableAdmission(platform->enable_cache_local_tinylfu());
+    remote_cache_->EnableAdmission(platform->enable_cache_remote_tinylfu());
 
-    pthread_mutex_init(&mutex_local_mt_, NULL);
+    pthread_rwlock_init(&rwlock_local_mt_, NULL);
     pthread_mutex_init(&mutex_local_imts_, NULL);
     pthread_mutex_init(&mutex_remote_imts_, NULL);
     pthread_mutex_init(&mutex_atomic_update_, NULL);
@@ -59,14 +67,17 @@ DB::DB(unsigned long dbid, const char* name, int flags, papyruskv_option_t* opt,
 
 DB::~DB() {
     WaitAll();
-    delete local_mt_;
+    compactor_->EnqueueWaitRelease(Command::Create(PAPYRUSKV_CMD_NOP));
+    MemTable::Release(local_mt_);
     delete remote_mt_;
     delete remote_buf_;
     delete local_cache_;
     delete remote_cache_;
+    if (window_) delete window_;
     delete sstable_;
     if (big_buffer_) free(big_buffer_);
-    pthread_mutex_destroy(&mutex_local_mt_);
+    delete[] epochs_;
+    pthread_rwlock_destroy(&rwlock_local_mt_);
     pthread_mutex_destroy(&mutex_local_imts_);
     pthread_mutex_destroy(&mutex_remote_imts_);
     pthread_mutex_destroy(&mutex_atomic_update_);
@@ -82,23 +93,110 @@ int DB::Put(const char* key, size_t keylen, const char* val, size_t vallen) {
     return rank == rank_ ? PutLocal(key, keylen, val, vallen, false) : PutRemote(key, keylen, val, vallen, false, rank);
 }
 
-int DB::PutLocal(Slice* slice) {
-    if (protection_ == PAPYRUSKV_RDWR || protection_ == PAPYRUSKV_UDONLY)
-        local_cache_->Invalidate(slice->key(), slice->keylen());
-    pthread_mutex_lock(&mutex_local_mt_);
-    size_t size = local_mt_->Put(slice);
-    if (size < memtable_size_) {
-        pthread_mutex_unlock(&mutex_local_mt_);
-        return PAPYRUSKV_OK;
+int DB::PutBatch(size_t n, const char** keys, const size_t* keylens, const char** vals, const size_t* vallens) {
+    if (protection_ == PAPYRUSKV_RDONLY) {
+        _error("dbid[%lu] protection[0x%x]", dbid_, protection_);
+        return PAPYRUSKV_ERR;
     }
-    int ret = Flush(false, false);
+    std::vector<std::vector<size_t> > parts(nranks_);
+    for (size_t i = 0; i < n; i++)
+        parts[hasher_->KeyRank(keys[i], keylens[i])].push_back(i);
+
+    int ret = PutLocalBatch(keys, keylens, vals, vallens, parts[rank_]);
     if (ret != PAPYRUSKV_OK) _error("ret[%d]", ret);
-    pthread_mutex_unlock(&mutex_local_mt_);
+
+    if (consistency_ == PAPYRUSKV_RELAXED && !enable_remote_buffer_ && !remote_mt_->Empty()) {
+        ret = Migrate(-1, false, PAPYRUSKV_MEMTABLE);
+        if (ret != PAPYRUSKV_OK) _error("ret[%d]", ret);
+    }
+
+    bool sync = consistency_ == PAPYRUSKV_SEQUENTIAL;
+    std::vector<Command*> cmds;
+    for (int rank = 0; rank < nranks_; rank++) {
+        std::vector<size_t>& idx = parts[rank];
+        if (rank == rank_ || idx.empty()) continue;
+        if (protection_ == PAPYRUSKV_RDWR || protection_ == PAPYRUSKV_UDONLY)
+            for (auto it = idx.begin(); it != idx.end(); ++it) remote_cache_->Invalidate(keys[*it], keylens[*it]);
+        if (consistency_ == PAPYRUSKV_RELAXED && enable_remote_buffer_ && remote_buf_->Size(rank)) {
+            ret = Migrate(rank, false, PAPYRUSKV_MEMTABLE);
+            if (ret != PAPYRUSKV_OK) _error("ret[%d] rank[%d]", ret, rank);
+        }
+
+        for (size_t begin = 0; begin < idx.size(); ) {
+            size_t size = 0UL;
+            size_t end = begin;
+            for (; end < idx.size(); end++) {
+                size_t entry = RemoteBuffer::EntrySize(keylens[idx[end]], vallens[idx[end]]);
+                if (end > begin && size + entry > PAPYRUSKV_BIG_BUFFER) break;
+                size += entry;
+            }
+            char* block;
+            if (posix_memalign((void**) &block, 0x10, size) != 0) {
+                _error("cannot alloc block[%lu]", size);
+                return PAPYRUSKV_ERR;
+            }
+            size_t off = 0UL;
+            for (size_t i = begin; i < end; i++) {
+                size_t k = idx[i];
+                off += RemoteBuffer::Pack(block + off, keys[k], keylens[k], vals[k], vallens[k], false);
+            }
+            _trace("rank[%d] begin[%lu] end[%lu] size[%lu] sync[%d]", rank, begin, end, size, sync);
+            Command* cmd = Command::CreateMigrate(this, block, size, rank, sync, PAPYRUSKV_MEMTABLE);
+            dispatcher_->Enqueue(cmd);
+            if (sync) cmds.push_back(cmd);
+            begin = end;
+        }
+    }
+
+    for (auto it = cmds.begin(); it != cmds.end(); ++it) {
+        Command* cmd = *it;
+        cmd->Wait();
+        if (cmd->ret() != PAPYRUSKV_OK) ret = cmd->ret();
+        Command::Release(cmd);
+    }
+    return ret;
+}
+
+int DB::PutLocalBatch(const char** keys, const size_t* keylens, const char** vals, const size_t* vallens, const std::vector<size_t>& idx) {
+    if (idx.empty()) return PAPYRUSKV_OK;
+    if (protection_ == PAPYRUSKV_RDWR || protection_ == PAPYRUSKV_UDONLY)
+        for (auto it = idx.begin(); it != idx.end(); ++it) local_cache_->Invalidate(keys[*it], keylens[*it]);
+    int ret = PAPYRUSKV_OK;
+    pthread_rwlock_rdlock(&rwlock_local_mt_);
+    for (auto it = idx.begin(); it != idx.end(); ++it) {
+        unsigned long mid = local_mt_->mid();
+        size_t size = local_mt_->Put(keys[*it], keylens[*it], vals[*it], vallens[*it], rank_, false);
+        if (size < memtable_size_) continue;
+        pthread_rwlock_unlock(&rwlock_local_mt_);
+        ret = FlushFull(mid);
+        if (ret != PAPYRUSKV_OK) _error("ret[%d]", ret);
+        pthread_rwlock_rdlock(&rwlock_local_mt_);
+    }
+    pthread_rwlock_unlock(&rwlock_local_mt_);
+    Advance();
     return ret;
 }
 
 int DB::PutLocal(const char* key, size_t keylen, const char* val, size_t vallen, bool tombstone) {
-    return PutLocal(new Slice(key, keylen, val, vallen, rank_, tombstone));
+    if (protection_ == PAPYRUSKV_RDWR || protection_ == PAPYRUSKV_UDONLY)
+        local_cache_->Invalidate(key, keylen);
+    pthread_rwlock_rdlock(&rwlock_local_mt_);
+    unsigned long mid = local_mt_->mid();
+    size_t size = local_mt_->Put(key, keylen, val, vallen, rank_, tombstone);
+    pthread_rwlock_unlock(&rwlock_local_mt_);
+    Advance();
+    if (size < memtable_size_) return PAPYRUSKV_OK;
+    int ret = FlushFull(mid);
+    if (ret != PAPYRUSKV_OK) _error("ret[%d]", ret);
+    return ret;
+}
+
+int DB::FlushFull(unsigned long mid) {
+    int ret = PAPYRUSKV_OK;
+    pthread_rwlock_wrlock(&rwlock_local_mt_);
+    if (local_mt_->mid() == mid) ret = Flush(false, false);
+    pthread_rwlock_unlock(&rwlock_local_mt_);
+    return ret;
 }
 
 int DB::PutRemote(const char* key, size_t keylen, const char* val, size_t vallen, bool tombstone, int rank) {
@@ -117,7 +215,7 @@ int DB::PutRemote(const char* key, size_t keylen, const char* val, size_t vallen
             }
             return remote_buf_->Put(key, keylen, val, vallen, tombstone, rank);
         }
-        size_t size = remote_mt_->Put(new Slice(key, keylen, val, vallen, rank, tombstone));
+        size_t size = remote_mt_->Put(key, keylen, val, vallen, rank, tombstone);
         if (size < memtable_size_) return PAPYRUSKV_OK;
         return Migrate(rank, false, PAPYRUSKV_MEMTABLE);
     }
@@ -132,17 +230,26 @@ int DB::Get(const char* key, size_t keylen, char** valp, size_t* vallenp, papyru
     return ret == PAPYRUSKV_SLICE_FOUND ? PAPYRUSKV_OK : PAPYRUSKV_ERR;
 }
 
+int DB::IGet(const char* key, size_t keylen, char** valp, size_t* vallenp, int* event) {
+    int rank = hasher_->KeyRank(key, keylen);
+    Command* cmd = Command::CreateGet(this, key, keylen, valp, vallenp, group_, rank);
+    int ret = rank == rank_ ? GetLocal(key, keylen, valp, vallenp, PAPYRUSKV_MEMTABLE | PAPYRUSKV_SSTABLE, NULL) : GetRemoteCached(key, keylen, valp, vallenp);
+    if (ret != PAPYRUSKV_SLICE_NOT_FOUND || rank == rank_) cmd->Complete(ret);
+    else dispatcher_->ExecuteIGet(cmd);
+    _trace("rank[%d] key[%s] keylen[%lu] ret[%x] cid[%lu]", rank, key, keylen, ret, cmd->cid());
+    *event = (int) cmd->cid();
+    events_[*event] = cmd;
+    return PAPYRUSKV_OK;
+}
+
 int DB::GetLocal(const char* key, size_t keylen, char** valp, size_t* vallenp, int mode, papyruskv_pos_t* pos) {
     int ret = PAPYRUSKV_SLICE_NOT_FOUND;
     if (pos) pos->handle = NULL;
     if (mode & PAPYRUSKV_MEMTABLE) {
-        pthread_mutex_lock(&mutex_local_mt_);
+        pthread_rwlock_rdlock(&rwlock_local_mt_);
         ret = local_mt_->Get(key, keylen, valp, vallenp, pos);
-        if (ret != PAPYRUSKV_SLICE_NOT_FOUND) {
-            pthread_mutex_unlock(&mutex_local_mt_);
-            return ret;
-        }
-        pthread_mutex_unlock(&mutex_local_mt_);
+        pthread_rwlock_unlock(&rwlock_local_mt_);
+        if (ret != PAPYRUSKV_SLICE_NOT_FOUND) return ret;
 
         pthread_mutex_lock(&mutex_local_imts_);
         for (auto it = local_imts_.begin(); it != local_imts_.end(); ++it) {
@@ -163,21 +270,16 @@ int DB::GetLocal(const char* key, size_t keylen, char** valp, size_t* vallenp, i
     return PAPYRUSKV_SLICE_NOT_FOUND;
 }
 
-int DB::GetSST(const char* key, size_t keylen, char** valp, size_t* vallenp, int rank, uint64_t sid) {
+int DB::GetSST(const char* key, size_t keylen, char** valp, size_t* vallenp, int rank, uint64_t sid, uint64_t version) {
     bool local = rank_ == rank;
     int ret = local ?
         sstable_->Get(key, keylen, valp, vallenp) :
-        sstable_->Get(key, keylen, valp, vallenp, rank, sid);
+        sstable_->Get(key, keylen, valp, vallenp, rank, sid, version);
 
     _trace("key[%s] keylen[%lu] val[%s] vallen[%lu] rank[%d] sid[%lu] local[%d]", key, keylen, *valp, *vallenp, rank, sid, local);
     
     if (local) {
-        if (ret == PAPYRUSKV_SLICE_FOUND)
-            local_cache_->Put(key, keylen, *valp, *vallenp, rank, false);
-        else if (ret == PAPYRUSKV_SLICE_TOMBSTONE)
-            local_cache_->Put(key, keylen, *valp, *vallenp, rank, true);
-        else if (ret == PAPYRUSKV_SLICE_NOT_FOUND)
-            local_cache_->Put(key, keylen, NULL, 0, rank, true);
+        CacheLocal(key, keylen, *valp, *vallenp, ret);
         return ret;
     }
     if (protection_ == PAPYRUSKV_RDONLY) {
@@ -192,6 +294,29 @@ int DB::GetSST(const char* key, size_t keylen, char** valp, size_t* vallenp, int
 }
 
 int DB::GetRemote(const char* key, size_t keylen, char** valp, size_t* vallenp, int rank, papyruskv_pos_t* pos) {
+    if (pos) pos->handle = NULL;
+
+    int ret = GetRemoteCached(key, keylen, valp, vallenp);
+    if (ret != PAPYRUSKV_SLICE_NOT_FOUND) return ret;
+
+    if (window_ && protection_ == PAPYRUSKV_RDONLY) {
+        ret = window_->Get(key, keylen, valp, vallenp, rank);
+        if (ret != PAPYRUSKV_SLICE_NOT_FOUND) {
+            CacheRemote(key, keylen, *valp, *vallenp, rank, ret, 0UL);
+            return ret;
+        }
+    }
+
+    uint64_t epoch = 0UL;
+    ret = dispatcher_->ExecuteGet(this, key, keylen, valp, vallenp, group_, rank, pos, &epoch);
+    _trace("key[%s] keylen[%lu] val[%s] vallen[%lu] ret[%x]", key, keylen, *valp, *vallenp, ret);
+
+    CacheRemote(key, keylen, *valp, *vallenp, rank, ret, epoch);
+
+    return ret;
+}
+
+int DB::GetRemoteCached(const char* key, size_t keylen, char** valp, size_t* vallenp) {
     int ret = PAPYRUSKV_SLICE_NOT_FOUND;
     if (!enable_remote_buffer_ && consistency_ == PAPYRUSKV_RELAXED) {
         pthread_mutex_lock(&mutex_remote_imts_);
@@ -211,27 +336,122 @@ int DB::GetRemote(const char* key, size_t keylen, char** valp, size_t* vallenp,
         pthread_mutex_unlock(&mutex_remote_imts_);
     }
 
-    if (pos) pos->handle = NULL;
+    if (protection_ == PAPYRUSKV_RDONLY || Leasing()) ret = remote_cache_->Get(key, keylen, valp, vallenp);
 
-    if (protection_ == PAPYRUSKV_RDONLY) {
-        ret = remote_cache_->Get(key, keylen, valp, vallenp);
-        if (ret != PAPYRUSKV_SLICE_NOT_FOUND) return ret;
+    return ret;
+}
+
+/* RDONLY entries live until the protection changes. Outside RDONLY a relaxed
+ * DB caches under a lease tagged with the owner's epoch from the reply. */
+void DB::CacheRemote(const char* key, size_t keylen, char* val, size_t vallen, int rank, int ret, uint64_t epoch) {
+    size_t lease = 0UL;
+    if (protection_ != PAPYRUSKV_RDONLY) {
+        if (!Leasing()) return;
+        Observe(rank, epoch);
+        lease = lease_;
+    }
+    if (ret == PAPYRUSKV_SLICE_FOUND)
+        remote_cache_->Put(key, keylen, val, vallen, rank, false, epoch, lease);
+    else if (ret == PAPYRUSKV_SLICE_TOMBSTONE)
+        remote_cache_->Put(key, keylen, val, vallen, rank, true, epoch, lease);
+    else if (ret == PAPYRUSKV_SLICE_NOT_FOUND)
+        remote_cache_->Put(key, keylen, NULL, 0, rank, true, epoch, lease);
+}
+
+void DB::Observe(int rank, uint64_t epoch) {
+    uint64_t known = __atomic_load_n(epochs_ + rank, __ATOMIC_ACQUIRE);
+    while (known < epoch && !__atomic_compare_exchange_n(epochs_ + rank, &known, epoch, true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+}
+
+void DB::CacheLocal(const char* key, size_t keylen, const char* val, size_t vallen, int ret) {
+    if (ret == PAPYRUSKV_SLICE_FOUND)
+        local_cache_->Put(key, keylen, val, vallen, rank_, false);
+    else if (ret == PAPYRUSKV_SLICE_TOMBSTONE)
+        local_cache_->Put(key, keylen, val, vallen, rank_, true);
+    else if (ret == PAPYRUSKV_SLICE_NOT_FOUND)
+        local_cache_->Put(key, keylen, NULL, 0, rank_, true);
+}
+
+int DB::GetView(const char* key, size_t keylen, const char** valp, size_t* vallenp, View** viewp) {
+    View* view = new View(platform_->pool());
+    int rank = hasher_->KeyRank(key, keylen);
+    int ret;
+    if (rank == rank_) ret = GetLocalView(key, keylen, view);
+    else {
+        char* val = NULL;
+        size_t vallen = 0UL;
+        ret = GetRemote(key, keylen, &val, &vallen, rank, NULL);
+        if (val) view->Own(val, vallen);
+    }
+    _trace("rank[%d] key[%s] keylen[%lu] vallen[%lu] ret[%x]", rank, key, keylen, view->vallen(), ret);
+    if (ret != PAPYRUSKV_SLICE_FOUND) {
+        delete view;
+        *valp = NULL;
+        if (vallenp) *vallenp = 0UL;
+        *viewp = NULL;
+        return PAPYRUSKV_ERR;
     }
+    *valp = view->val();
+    if (vallenp) *vallenp = view->vallen();
+    *viewp = view;
+    return PAPYRUSKV_OK;
+}
 
-    if (ret == PAPYRUSKV_SLICE_NOT_FOUND) {
-        ret = dispatcher_->ExecuteGet(this, key, keylen, valp, vallenp, group_, rank, pos);
-        _trace("key[%s] keylen[%lu] val[%s] vallen[%lu] ret[%x]", key, keylen, *valp, *vallenp, ret);
+int DB::GetLocalView(const char* key, size_t keylen, View* view) {
+    pthread_rwlock_rdlock(&rwlock_local_mt_);
+    int ret = local_mt_->GetView(key, keylen, view);
+    pthread_rwlock_unlock(&rwlock_local_mt_);
+    if (ret != PAPYRUSKV_SLICE_NOT_FOUND) return ret;
+
+    pthread_mutex_lock(&mutex_local_imts_);
+    for (auto it = local_imts_.begin(); it != local_imts_.end(); ++it) {
+        ret = (*it)->GetView(key, keylen, view);
+        if (ret != PAPYRUSKV_SLICE_NOT_FOUND) {
+            pthread_mutex_unlock(&mutex_local_imts_);
+            return ret;
+        }
     }
+    pthread_mutex_unlock(&mutex_local_imts_);
 
-    if (protection_ == PAPYRUSKV_RDONLY) {
-        if (ret == PAPYRUSKV_SLICE_FOUND)
-            remote_cache_->Put(key, keylen, *valp, *vallenp, rank, false);
-        else if (ret == PAPYRUSKV_SLICE_TOMBSTONE)
-            remote_cache_->Put(key, keylen, *valp, *vallenp, rank, true);
-        else if (ret == PAPYRUSKV_SLICE_NOT_FOUND)
-            remote_cache_->Put(key, keylen, NULL, 0, rank, true);
+    ret = local_cache_->GetView(key, keylen, view);
+    if (ret != PAPYRUSKV_SLICE_NOT_FOUND) return ret;
+
+    ret = sstable_->GetView(key, keylen, view);
+    CacheLocal(key, keylen, view->val(), view->vallen(), ret);
+    return ret;
+}
+
+int DB::ReleaseView(View* view) {
+    delete view;
+    return PAPYRUSKV_OK;
+}
+
+int DB::GetBatch(size_t n, const char** keys, const size_t* keylens, char** vals, size_t* vallens, int* rets) {
+    std::vector<std::vector<size_t> > pending(nranks_);
+    std::vector<uint64_t> epochs(n);
+    for (size_t i = 0; i < n; i++) {
+        int rank = hasher_->KeyRank(keys[i], keylens[i]);
+        if (rank == rank_) rets[i] = GetLocal(keys[i], keylens[i], vals + i, vallens + i, PAPYRUSKV_MEMTABLE | PAPYRUSKV_SSTABLE, NULL);
+        else {
+            rets[i] = GetRemoteCached(keys[i], keylens[i], vals + i, vallens + i);
+            if (rets[i] == PAPYRUSKV_SLICE_NOT_FOUND) pending[rank].push_back(i);
+        }
+    }
+
+    for (int rank = 0; rank < nranks_; rank++) {
+        if (pending[rank].empty()) continue;
+        int ret = dispatcher_->ExecuteGetBatch(this, keys, keylens, vals, vallens, rets, epochs.data(), pending[rank], group_, rank);
+        if (ret != PAPYRUSKV_OK) _error("ret[%d] rank[%d]", ret, rank);
+        for (auto it = pending[rank].begin(); it != pending[rank].end(); ++it)
+            CacheRemote(keys[*it], keylens[*it], vals[*it], vallens[*it], rank, rets[*it], epochs[*it]);
     }
 
+    int ret = PAPYRUSKV_OK;
+    for (size_t i = 0; i < n; i++) {
+        _trace("key[%s] keylen[%lu] vallen[%lu] ret[%x]", keys[i], keylens[i], vallens[i], rets[i]);
+        rets[i] = rets[i] == PAPYRUSKV_SLICE_FOUND ? PAPYRUSKV_OK : PAPYRUSKV_ERR;
+        if (rets[i] != PAPYRUSKV_OK) ret = PAPYRUSKV_ERR;
+    }
     return ret;
 }
 
@@ -265,6 +485,14 @@ int DB::Barrier(int level) {
 
     MPI_Barrier(mpi_comm_);
 
+    if (Leasing()) {
+        uint64_t epoch = this->epoch();
+        uint64_t* epochs = new uint64_t[nranks_];
+        MPI_Allgather(&epoch, 1, MPI_LONG_LONG_INT, epochs, 1, MPI_LONG_LONG_INT, mpi_comm_);
+        for (int i = 0; i < nranks_; i++) Observe(i, epochs[i]);
+        delete[] epochs;
+    }
+
     return PAPYRUSKV_OK;
 }
 
@@ -289,16 +517,18 @@ int DB::Migrate(int rank, bool sync, int level) {
 }
 
 int DB::Flush(bool sync, bool lock) {
-    Command* cmd = Command::CreateFlush(local_mt_, sync);
-    if (lock) pthread_mutex_lock(&mutex_local_mt_);
-    if (!local_mt_->Empty()) {
-        local_mt_->SortByKey();
+    if (lock) pthread_rwlock_wrlock(&rwlock_local_mt_);
+    MemTable* mt = local_mt_;
+    if (!mt->Empty()) {
+        mt->SortByKey();
         pthread_mutex_lock(&mutex_local_imts_);
-        local_imts_.push_front(local_mt_);
+        local_imts_.push_front(mt);
         pthread_mutex_unlock(&mutex_local_imts_);
         local_mt_ = new MemTable(this, true);
-    }
-    if (lock) pthread_mutex_unlock(&mutex_local_mt_);
+    } else mt = NULL;
+    if (lock) pthread_rwlock_unlock(&rwlock_local_mt_);
+    if (mt == NULL && !sync) return PAPYRUSKV_OK;
+    Command* cmd = mt ? Command::CreateFlush(mt, sync) : Command::Create(PAPYRUSKV_CMD_NOP);
     if (sync) compactor_->EnqueueWaitRelease(cmd);
     else compactor_->Enqueue(cmd);
     return PAPYRUSKV_OK;
@@ -327,7 +557,8 @@ int DB::SetProtection(int protection) {
     }
     if (protection_ == protection) return PAPYRUSKV_OK;
     if (protection_ == PAPYRUSKV_WRONLY) local_cache_->InvalidateAll();
-    if (protection == PAPYRUSKV_RDONLY) remote_cache_->InvalidateAll();
+    if (protection_ == PAPYRUSKV_RDONLY || protection == PAPYRUSKV_RDONLY) remote_cache_->InvalidateAll();
+    if (window_ && protection_ == PAPYRUSKV_RDONLY) window_->Withdraw();
     if (protection != PAPYRUSKV_RDONLY && protection != PAPYRUSKV_UDONLY) local_mt_->ClearBucket();
 
     protection_ = protection;
@@ -347,6 +578,7 @@ int DB::Checkpoint(const char* path, int* event) {
         return ret;
     }
 
+    sstable_->Pin();
     uint64_t sid = sstable_->sid();
     uint64_t* sids = new uint64_t[nranks_];
     MPI_Gather(&sid, 1, MPI_LONG_LONG_INT, sids, 1, MPI_LONG_LONG_INT, 0, mpi_comm_);
@@ -398,30 +630,65 @@ int DB::Wait(int event) {
     auto it = events_.find(event);
     if (it == events_.end()) return PAPYRUSKV_OK;
     Command* cmd = it->second;
-    cmd->Wait();
+    int ret = Complete(cmd);
     if (cmd->type() == PAPYRUSKV_CMD_RESTART) MPI_Barrier(mpi_comm_);
     Command::Release(cmd);
     events_.erase(it);
-    return PAPYRUSKV_OK;
+    return ret;
+}
+
+int DB::Test(int event, int* flag) {
+    auto it = events_.find(event);
+    if (it == events_.end()) {
+        *flag = 1;
+        return PAPYRUSKV_OK;
+    }
+    Command* cmd = it->second;
+    if (cmd->type() == PAPYRUSKV_CMD_GET && !cmd->Test()) MPI_Test(cmd->request(), flag, MPI_STATUS_IGNORE);
+    else *flag = cmd->Test() ? 1 : 0;
+    return *flag ? Wait(event) : PAPYRUSKV_OK;
 }
 
 int DB::WaitAll() {
     for (auto it = events_.begin(); it != events_.end(); ++it) {
         Command* cmd = it->second;
         if (cmd->type() == PAPYRUSKV_CMD_RESTART) continue;
-        cmd->Wait();
+        Complete(cmd);
         Command::Release(cmd);
     }
     events_.clear();
     return PAPYRUSKV_OK;
 }
 
+int DB::CacheStat(papyruskv_cache_stat_t* local, papyruskv_cache_stat_t* remote) {
+    if (local) local_cache_->Stat(local);
+    if (remote) remote_cache_->Stat(remote);
+    return PAPYRUSKV_OK;
+}
+
+int DB::Complete(Command* cmd) {
+    if (cmd->type() != PAPYRUSKV_CMD_GET) {
+        cmd->Wait();
+        return PAPYRUSKV_OK;
+    }
+    if (!cmd->Test()) {
+        uint64_t epoch = 0UL;
+        int ret = dispatcher_->CompleteIGet(cmd, &epoch);
+        CacheRemote(cmd->key(), cmd->keylen(), *cmd->valp(), *cmd->vallenp(), cmd->rank(), ret, epoch);
+        cmd->Complete(ret);
+    }
+    return cmd->ret() == PAPYRUSKV_SLICE_FOUND ? PAPYRUSKV_OK : PAPYRUSKV_ERR;
+}
+
 int DB::Hash() {
     if (protection_ != PAPYRUSKV_RDONLY && protection_ != PAPYRUSKV_UDONLY)
         return PAPYRUSKV_ERR;
-    pthread_mutex_lock(&mutex_local_mt_);
-    if (!local_mt_->Empty()) local_mt_->Hash();
-    pthread_mutex_unlock(&mutex_local_mt_);
+    pthread_rwlock_wrlock(&rwlock_local_mt_);
+    if (!local_mt_->Empty()) {
+        local_mt_->Hash();
+        if (window_ && protection_ == PAPYRUSKV_RDONLY) window_->Expose(local_mt_);
+    }
+    pthread_rwlock_unlock(&rwlock_local_mt_);
     return PAPYRUSKV_OK;
 }
 
@@ -429,7 +696,7 @@ int DB::IterLocal(papyruskv_iter_t* iter) {
     MemTable* head = NULL;
     MemTable* tail = NULL;
 
-    pthread_mutex_lock(&mutex_local_mt_);
+    pthread_rwlock_rdlock(&rwlock_local_mt_);
     if (!local_mt_->Empty()) {
 #if 1
         head = MemTable::Duplicate(local_mt_);
@@ -440,7 +707,7 @@ int DB::IterLocal(papyruskv_iter_t* iter) {
         head->SortByKey();
         tail = head;
     }
-    pthread_mutex_unlock(&mutex_local_mt_);
+    pthread_rwlock_unlock(&rwlock_local_mt_);
 
     pthread_mutex_lock(&mutex_local_imts_);
     if (!local_imts_.empty()) {
@@ -456,20 +723,24 @@ int DB::IterLocal(papyruskv_iter_t* iter) {
     }
     pthread_mutex_unlock(&mutex_local_imts_);
 
-    uint64_t sid = sstable_->sid();
+    sstable_->Pin();
+    uint64_t sid = tail ? sstable_->Next(tail->mid()) : sstable_->sid();
     if (head == NULL && sid != 0) {
         head = new MemTable(this);
         sstable_->Load(head, sid);
-        if (sid > 1) {
-            MemTable* next = new MemTable(this);
-            Command* cmd = Command::CreateLoad(next, sid - 1);
-            compactor_->Enqueue(cmd);
-            next->set_cmd(cmd);
-            head->set_next(next);
-        }
+        tail = head;
+        sid = sstable_->Next(sid);
+    }
+    if (tail && sid) {
+        MemTable* next = new MemTable(this);
+        Command* cmd = Command::CreateLoad(next, sid);
+        compactor_->Enqueue(cmd);
+        next->set_cmd(cmd);
+        tail->set_next(next);
     }
 
     if (head == NULL) {
+        sstable_->Unpin();
         *iter = NULL;
         return PAPYRUSKV_OK;
     }
@@ -492,6 +763,8 @@ int DB::IterNext(papyruskv_iter_t* iter) {
     MemTable* next_mt = mt->next();
     MemTable::Release(mt);
     if (next_mt == NULL) {
+        sstable_->Unpin();
+        delete *iter;
         *iter = NULL;
         return PAPYRUSKV_OK;
     }
@@ -500,15 +773,17 @@ int DB::IterNext(papyruskv_iter_t* iter) {
         Command* cmd = next_mt->cmd();
         cmd->Wait();
         Command::Release(cmd);
+        next_mt->set_cmd(NULL);
     }
 
     slice = next_mt->head();
     slice->CopyIter(*iter);
 
     MemTable* next_next_mt = next_mt->next();
-    if (next_next_mt == NULL && next_mt->mid() > 1) {
+    uint64_t next_sid = next_next_mt == NULL ? sstable_->Next(next_mt->mid()) : 0UL;
+    if (next_sid) {
         next_next_mt = new MemTable(this);
-        Command* cmd = Command::CreateLoad(next_next_mt, next_mt->mid() - 1);
+        Command* cmd = Command::CreateLoad(next_next_mt, next_sid);
         compactor_->Enqueue(cmd);
         next_next_mt->set_cmd(cmd);
         next_mt->set_next(next_next_mt);
@@ -517,6 +792,27 @@ int DB::IterNext(papyruskv_iter_t* iter) {
     return PAPYRUSKV_OK;
 }
 
+/* Ends an iteration early: releases the tables still ahead of it, waiting
+ * for a pending load, and lets compaction run again. */
+int DB::IterFree(papyruskv_iter_t* iter) {
+    if (*iter == NULL) return PAPYRUSKV_OK;
+    MemTable* mt = ((Slice*) (*iter)->handle)->mt();
+    while (mt) {
+        MemTable* next = mt->next();
+        if (mt->cmd()) {
+            Command* cmd = mt->cmd();
+            cmd->Wait();
+            Command::Release(cmd);
+        }
+        MemTable::Release(mt);
+        mt = next;
+    }
+    sstable_->Unpin();
+    delete *iter;
+    *iter = NULL;
+    return PAPYRUSKV_OK;
+}
+
 int DB::RegisterUpdate(int fnid, papyruskv_update_fn_t ufn) {
     if (user_ufns_.count(fnid)) {
         _error("fnid[%d]", fnid);
@@ -564,6 +860,7 @@ int DB::UpdateLocal(const char* key, size_t keylen, papyruskv_pos_t* pos, int fn
         if (protection_ == PAPYRUSKV_UDONLY && new_pos.handle) {
             Slice* slice = (Slice*) new_pos.handle;
             memcpy(slice->val(), val, vallen);
+            Advance();
         } else {
             iret = PutLocal(key, keylen, (const char*) val, vallen, false);
             if (iret != PAPYRUSKV_OK) _error("ret[%d] key[%s] keylen[%lu] val[%s] vallen[%lu]", iret, key, keylen, val, vallen);
@@ -575,6 +872,7 @@ int DB::UpdateLocal(const char* key, size_t keylen, papyruskv_pos_t* pos, int fn
 }
 
 int DB::UpdateRemote(const char* key, size_t keylen, papyruskv_pos_t* pos, int fnid, void* userin, size_t userinlen, void* userout, size_t useroutlen, int rank) {
+    remote_cache_->Invalidate(key, keylen);
     return dispatcher_->ExecuteUpdate(this, key, keylen, pos, fnid, userin, userinlen, userout, useroutlen, rank);
 }
 
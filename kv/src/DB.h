@@ -11,6 +11,8 @@
 #include "RemoteBuffer.h"
 #include "Cache.h"
 #include "SSTable.h"
+#include "View.h"
+#include "Window.h"
 #include <unordered_map>
 #include <list>
 
@@ -24,14 +26,18 @@ public:
     ~DB();
 
     int Put(const char* key, size_t keylen, const char* val, size_t vallen);
-    int PutLocal(Slice* slice);
+    int PutBatch(size_t n, const char** keys, const size_t* keylens, const char** vals, const size_t* vallens);
     int PutLocal(const char* key, size_t keylen, const char* val, size_t vallen, bool tombstone);
     int PutRemote(const char* key, size_t keylen, const char* val, size_t vallen, bool tombstone, int rank);
 
     int Get(const char* key, size_t keylen, char** valp, size_t* vallenp, papyruskv_pos_t* pos);
+    int IGet(const char* key, size_t keylen, char** valp, size_t* vallenp, int* event);
     int GetLocal(const char* key, size_t keylen, char** valp, size_t* vallenp, int mode, papyruskv_pos_t* pos);
     int GetRemote(const char* key, size_t keylen, char** valp, size_t* vallenp, int rank, papyruskv_pos_t* pos);
-    int GetSST(const char* key, size_t keylen, char** valp, size_t* vallenp, int rank, uint64_t sid = 0);
+    int GetSST(const char* key, size_t keylen, char** valp, size_t* vallenp, int rank, uint64_t sid = 0, uint64_t version = 0);
+    int GetBatch(size_t n, const char** keys, const size_t* keylens, char** vals, size_t* vallens, int* rets);
+    int GetView(const char* key, size_t keylen, const char** valp, size_t* vallenp, View** viewp);
+    int ReleaseView(View* view);
 
     int Delete(const char* key, size_t keylen);
 
@@ -46,11 +52,14 @@ public:
     int Checkpoint(const char* path, int* event);
     int Restart(const char* path, int* event);
     int Wait(int event);
+    int Test(int event, int* flag);
     int WaitAll();
+    int CacheStat(papyruskv_cache_stat_t* local, papyruskv_cache_stat_t* remote);
 
     int Hash();
     int IterLocal(papyruskv_iter_t* iter);
     int IterNext(papyruskv_iter_t* iter);
+    int IterFree(papyruskv_iter_t* iter);
 
     int RegisterUpdate(int fnid, papyruskv_update_fn_t ufn);
 
@@ -74,11 +83,24 @@ public:
 
     size_t keylen() const { return keylen_; }
     size_t vallen() const { return vallen_; }
+    size_t get_eager() const { return get_eager_; }
     bool enable_remote_buffer() const { return enable_remote_buffer_; }
+    uint64_t epoch() const { return __atomic_load_n(&epoch_, __ATOMIC_ACQUIRE); }
+    uint64_t epoch(int rank) const { return __atomic_load_n(epochs_ + rank, __ATOMIC_ACQUIRE); }
 
 private:
+    int Complete(Command* cmd);
+    int FlushFull(unsigned long mid);
+    int PutLocalBatch(const char** keys, const size_t* keylens, const char** vals, const size_t* vallens, const std::vector<size_t>& idx);
+    int GetRemoteCached(const char* key, size_t keylen, char** valp, size_t* vallenp);
+    void CacheRemote(const char* key, size_t keylen, char* val, size_t vallen, int rank, int ret, uint64_t epoch);
+    void CacheLocal(const char* key, size_t keylen, const char* val, size_t vallen, int ret);
+    int GetLocalView(const char* key, size_t keylen, View* view);
     int Migrate(int rank, bool sync, int level);
     int Migrate(bool sync, int level);
+    bool Leasing() const { return lease_ > 0 && consistency_ == PAPYRUSKV_RELAXED; }
+    void Advance() { __atomic_add_fetch(&epoch_, 1, __ATOMIC_RELEASE); }
+    void Observe(int rank, uint64_t epoch);
 
 private:
     unsigned long dbid_;
@@ -91,12 +113,17 @@ private:
     size_t memtable_size_;
     size_t remote_buf_size_;
     size_t cache_size_;
+    size_t lease_;
     bool enable_remote_buffer_;
     MPI_Comm mpi_comm_;
     MPI_Comm mpi_comm_ext_;
 
     size_t keylen_;
     size_t vallen_;
+    size_t get_eager_;
+
+    uint64_t epoch_;
+    uint64_t* epochs_;
 
     Platform* platform_;
     Dispatcher* dispatcher_;
@@ -107,6 +134,7 @@ private:
     RemoteBuffer* remote_buf_;
     Cache* local_cache_;
     Cache* remote_cache_;
+    Window* window_;
     SSTable* sstable_;
 
     char* big_buffer_;
@@ -116,7 +144,7 @@ private:
 
     std::unordered_map<int, Command*> events_;
 
-    pthread_mutex_t mutex_local_mt_;
+    pthread_rwlock_t rwlock_local_mt_;
     pthread_mutex_t mutex_local_imts_;
     pthread_mutex_t mutex_remote_imts_;
     pthread_mutex_t mutex_atomic_update_;
@@ -10,23 +10,56 @@
 #define PAPYRUSKV_REMOTE_BUFFER_SIZE        (128UL * 1024)
 #define PAPYRUSKV_REMOTE_BUFFER_ENTRY_MAX   (4UL   * 1024)
 #define PAPYRUSKV_CACHE_SIZE                (128UL * 1024 * 1024)
+#define PAPYRUSKV_CACHE_SHARDS              16
+#define PAPYRUSKV_CACHE_LEASE               0
+#define PAPYRUSKV_TABLE_CACHE_SIZE          (256UL * 1024 * 1024)
+#define PAPYRUSKV_POOL_SIZE                 (16UL  * 1024 * 1024)
+#define PAPYRUSKV_SHM_SIZE                  (32UL  * 1024 * 1024)
 #define PAPYRUSKV_MAX_KEYLEN                (16UL  * 1024)
 #define PAPYRUSKV_MAX_VALLEN                (16UL  * 1024 * 1024)
 #define PAPYRUSKV_BIG_BUFFER                (32UL  * 1024 * 1024)
+#define PAPYRUSKV_TABLE_BUFFER              (1UL   * 1024 * 1024)
+#define PAPYRUSKV_BLOCK_SIZE                (4UL   * 1024)
+#define PAPYRUSKV_BLOCK_RESTART             16
+#define PAPYRUSKV_ARENA_BLOCK               (1UL   * 1024 * 1024)
+#define PAPYRUSKV_LISTENER_THREADS          4
+#define PAPYRUSKV_LISTENER_QUEUE            1024
+#define PAPYRUSKV_WORKER_BUFFER             (64UL  * 1024)
+#define PAPYRUSKV_FLUSH_THREADS             4
+#define PAPYRUSKV_FLUSH_QUEUE               4
+#define PAPYRUSKV_MIGRATE_WINDOW            64
+#define PAPYRUSKV_GET_EAGER                 (8UL   * 1024)
+#define PAPYRUSKV_WINDOW_PEEK               512
 
 #define PAPYRUSKV_SLICE_FOUND               0x1
 #define PAPYRUSKV_SLICE_TOMBSTONE           0x2
 #define PAPYRUSKV_SLICE_NOT_FOUND           0x3
+#define PAPYRUSKV_SLICE_RETRY               0x4
+
+#define PAPYRUSKV_GET_PACKET                7
+#define PAPYRUSKV_SHM_NONE                  (~0UL)
 
 #define PAPYRUSKV_SSTABLE_SEQ               0x1
 #define PAPYRUSKV_SSTABLE_BIN               0x2
+#define PAPYRUSKV_SSTABLE_MMAP              0x4
 
 #define PAPYRUSKV_REMOTE_BUFFER             false
 #define PAPYRUSKV_CACHE_LOCAL               false
 #define PAPYRUSKV_CACHE_REMOTE              false
+#define PAPYRUSKV_CACHE_CLOCK               false
+#define PAPYRUSKV_CACHE_LOCAL_TINYLFU       false
+#define PAPYRUSKV_CACHE_REMOTE_TINYLFU      false
+#define PAPYRUSKV_RMA                       false
+#define PAPYRUSKV_DIRECT_IO                 false
 
 #define PAPYRUSKV_BLOOM                     true
-#define PAPYRUSKV_BLOOM_BITS                (64 * 1024 * 4)
+#define PAPYRUSKV_BLOOM_FPR                 0.01
+#define PAPYRUSKV_BLOOM_BLOCKED             true
+
+#define PAPYRUSKV_COMPACTION                true
+#define PAPYRUSKV_COMPACTION_TRIGGER        4
+#define PAPYRUSKV_COMPACTION_RATIO          10
+#define PAPYRUSKV_MAX_LEVEL                 7
 
 #define PAPYRUSKV_DESTROY_REPOSITORY        true
 #define PAPYRUSKV_FORCE_REDISTRIBUTE        false
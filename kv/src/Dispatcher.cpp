@@ -14,6 +14,7 @@ Dispatcher::Dispatcher(Platform* platform) {
     mpi_comm_ = platform_->mpi_comm();
     mpi_comm_ext_ = platform_->mpi_comm_ext();
     pool_ = platform_->pool();
+    shm_ = platform_->shm();
     rank_ = platform->rank();
     nranks_ = platform->size();
     queue_ = new LockFreeQueueMS<Command*>(1024);
@@ -87,7 +88,7 @@ int Dispatcher::ExecutePut(DB* db, const char* key, size_t keylen, const char* v
     return *ret_buffer_;
 }
 
-int Dispatcher::ExecuteGet(DB* db, const char* key, size_t keylen, char** valp, size_t* vallenp, int group, int rank, papyruskv_pos_t* pos) {
+int Dispatcher::ExecuteGet(DB* db, const char* key, size_t keylen, char** valp, size_t* vallenp, int group, int rank, papyruskv_pos_t* pos, uint64_t* epochp) {
     unsigned long cid = Platform::NewCID();
     int tag = Tag(cid);
 
@@ -102,8 +103,7 @@ int Dispatcher::ExecuteGet(DB* db, const char* key, size_t keylen, char** valp,
     msg.WriteInt(group);
     msg.Send(rank, mpi_comm_);
 
-    if (db->vallen()) MPI_Recv(big_buffer_, 5 * sizeof(size_t) + db->vallen(), MPI_CHAR, rank, tag, mpi_comm_ext_, MPI_STATUS_IGNORE);
-    else MPI_Recv(big_buffer_, 5, MPI_LONG_LONG, rank, tag, mpi_comm_ext_, MPI_STATUS_IGNORE);
+    MPI_Recv(big_buffer_, (int) (PAPYRUSKV_GET_PACKET * sizeof(size_t) + db->get_eager()), MPI_CHAR, rank, tag, mpi_comm_ext_, MPI_STATUS_IGNORE);
 
     size_t* packet = (size_t*) big_buffer_;
     int ret = (int) packet[0];
@@ -111,80 +111,204 @@ int Dispatcher::ExecuteGet(DB* db, const char* key, size_t keylen, char** valp,
     size_t vallen = packet[2];
     uint64_t sid = packet[3];
     size_t pos_handle = packet[4];
+    uint64_t version = packet[6];
+    if (epochp) *epochp = packet[5];
 
-    _trace("ret[%d] mode[%d] vallen[%lu] sid[%lu] pos_handle[0x%x]", ret, mode, vallen, sid, pos_handle);
+    _trace("ret[%d] mode[%d] vallen[%lu] sid[%lu] pos_handle[0x%x] epoch[%lu]", ret, mode, vallen, sid, pos_handle, packet[5]);
 
     if (ret == PAPYRUSKV_SLICE_FOUND) {
         if (vallenp) *vallenp = vallen;
         if (valp) {
             if (*valp == NULL) *valp = pool_->AllocVal(vallen);
-            if (db->keylen()) {
-                memcpy(*valp, big_buffer_ + 5 * sizeof(size_t), vallen);
-            }
+            if (vallen <= db->get_eager()) memcpy(*valp, big_buffer_ + PAPYRUSKV_GET_PACKET * sizeof(size_t), vallen);
             else MPI_Recv(*valp, (int) vallen, MPI_CHAR, rank, tag, mpi_comm_ext_, MPI_STATUS_IGNORE);
         }
         if (pos && pos_handle) pos->handle = (void*) pos_handle;
     } else if (ret == PAPYRUSKV_SLICE_NOT_FOUND && mode == PAPYRUSKV_MEMTABLE) {
-        ret = db->GetSST(key, keylen, valp, vallenp, rank, sid);
+        ret = db->GetSST(key, keylen, valp, vallenp, rank, sid, version);
+        if (ret == PAPYRUSKV_SLICE_RETRY) ret = ExecuteGet(db, key, keylen, valp, vallenp, -1, rank, pos, epochp);
     }
     return ret;
 }
 
-void Dispatcher::ExecuteMigrate(Command* cmd) {
-    return cmd->db()->enable_remote_buffer() ? ExecuteMigrateRemoteBuffer(cmd) : ExecuteMigrateMemTable(cmd);
-}
+int Dispatcher::ExecuteIGet(Command* cmd) {
+    DB* db = cmd->db();
+    int tag = cmd->tag();
+    size_t packetlen = PAPYRUSKV_GET_PACKET * sizeof(size_t) + db->get_eager();
 
-void Dispatcher::ExecuteMigrateRemoteBuffer(Command* cmd) {
-    int tag = Tag(cmd->cid());
-    bool sync = cmd->sync();
+    _trace("cid[%lu] tag[%d] key[%s] keylen[%lu] group[%d] rank[%d]", cmd->cid(), tag, cmd->key(), cmd->keylen(), cmd->group(), cmd->rank());
 
-    Message msg(PAPYRUSKV_MSG_MIGRATE);
-    msg.WriteULong(cmd->dbid());
+    Message msg(PAPYRUSKV_MSG_GET);
+    msg.WriteULong(db->dbid());
     msg.WriteInt(tag);
-    msg.WriteBool(sync);
-    msg.WriteInt(cmd->level());
-    msg.WriteULong(cmd->size());
+    msg.WriteULong(cmd->keylen());
+    msg.Write(cmd->key(), cmd->keylen());
+    msg.WritePtr(cmd->valp());
+    msg.WriteInt(cmd->group());
     msg.Send(cmd->rank(), mpi_comm_);
 
-    MPI_Send(cmd->block(), (int) cmd->size(), MPI_CHAR, cmd->rank(), tag, mpi_comm_);
-    MPI_Recv(ret_buffer_, 1, MPI_INT, cmd->rank(), tag, mpi_comm_ext_, MPI_STATUS_IGNORE);
+    MPI_Irecv(cmd->block(), (int) packetlen, MPI_CHAR, cmd->rank(), tag, mpi_comm_ext_, cmd->request());
+    return PAPYRUSKV_OK;
+}
 
-    free(cmd->block());
+int Dispatcher::CompleteIGet(Command* cmd, uint64_t* epochp) {
+    DB* db = cmd->db();
+    int rank = cmd->rank();
+    char** valp = cmd->valp();
+    size_t* vallenp = cmd->vallenp();
+    MPI_Wait(cmd->request(), MPI_STATUS_IGNORE);
 
-    cmd->Complete();
+    size_t* packet = (size_t*) cmd->block();
+    int ret = (int) packet[0];
+    int mode = (int) packet[1];
+    size_t vallen = packet[2];
+    uint64_t sid = packet[3];
+    uint64_t version = packet[6];
+    if (epochp) *epochp = packet[5];
+
+    _trace("cid[%lu] ret[%d] mode[%d] vallen[%lu] sid[%lu] epoch[%lu]", cmd->cid(), ret, mode, vallen, sid, packet[5]);
+
+    if (ret == PAPYRUSKV_SLICE_FOUND) {
+        if (vallenp) *vallenp = vallen;
+        if (valp) {
+            if (*valp == NULL) *valp = pool_->AllocVal(vallen);
+            if (vallen <= db->get_eager()) memcpy(*valp, cmd->block() + PAPYRUSKV_GET_PACKET * sizeof(size_t), vallen);
+            else MPI_Recv(*valp, (int) vallen, MPI_CHAR, rank, cmd->tag(), mpi_comm_ext_, MPI_STATUS_IGNORE);
+        }
+    } else if (ret == PAPYRUSKV_SLICE_NOT_FOUND && mode == PAPYRUSKV_MEMTABLE) {
+        ret = db->GetSST(cmd->key(), cmd->keylen(), valp, vallenp, rank, sid, version);
+        if (ret == PAPYRUSKV_SLICE_RETRY) ret = ExecuteGet(db, cmd->key(), cmd->keylen(), valp, vallenp, -1, rank, NULL, epochp);
+    }
+    return ret;
+}
+
+int Dispatcher::ExecuteGetBatch(DB* db, const char** keys, const size_t* keylens, char** vals, size_t* vallens, int* rets, uint64_t* epochs, const std::vector<size_t>& idx, int group, int rank) {
+    const size_t half = PAPYRUSKV_BIG_BUFFER / 2;
+    std::vector<size_t> deferred;
+    for (size_t begin = 0; begin < idx.size(); ) {
+        unsigned long cid = Platform::NewCID();
+        int tag = Tag(cid);
+
+        size_t size = 0UL;
+        size_t end = begin;
+        for (; end < idx.size(); end++) {
+            size_t keylen = keylens[idx[end]];
+            if (end > begin && (size + sizeof(size_t) + keylen > half || (end - begin + 1) * 3 * sizeof(size_t) + 3 * sizeof(size_t) > half)) break;
+            *((size_t*) (big_buffer_ + size)) = keylen;
+            size += sizeof(size_t);
+            memcpy(big_buffer_ + size, keys[idx[end]], keylen);
+            size += keylen;
+        }
+
+        _trace("cid[%lu] tag[%d] begin[%lu] end[%lu] size[%lu] group[%d] rank[%d]", cid, tag, begin, end, size, group, rank);
+
+        Message msg(PAPYRUSKV_MSG_GET_BATCH);
+        msg.WriteULong(db->dbid());
+        msg.WriteInt(tag);
+        msg.WriteInt(group);
+        msg.WriteULong(end - begin);
+        msg.WriteULong(size);
+        msg.Send(rank, mpi_comm_);
+
+        MPI_Send(big_buffer_, (int) size, MPI_CHAR, rank, tag, mpi_comm_);
+
+        MPI_Status status;
+        int count = 0;
+        MPI_Probe(rank, tag, mpi_comm_ext_, &status);
+        MPI_Get_count(&status, MPI_CHAR, &count);
+        MPI_Recv(big_buffer_, count, MPI_CHAR, rank, tag, mpi_comm_ext_, MPI_STATUS_IGNORE);
+
+        uint64_t sid = ((size_t*) big_buffer_)[0];
+        uint64_t epoch = ((size_t*) big_buffer_)[1];
+        uint64_t version = ((size_t*) big_buffer_)[2];
+        size_t off = 3 * sizeof(size_t);
+        for (size_t i = begin; i < end; i++) {
+            size_t* packet = (size_t*) (big_buffer_ + off);
+            int ret = (int) packet[0];
+            int mode = (int) packet[1];
+            size_t vallen = packet[2];
+            off += 3 * sizeof(size_t);
+            size_t k = idx[i];
+            if (ret == PAPYRUSKV_SLICE_FOUND) {
+                vallens[k] = vallen;
+                if (vals[k] == NULL) vals[k] = pool_->AllocVal(vallen);
+                memcpy(vals[k], big_buffer_ + off, vallen);
+                off += vallen;
+            } else if (ret == PAPYRUSKV_SLICE_NOT_FOUND && mode == PAPYRUSKV_MEMTABLE) {
+                ret = db->GetSST(keys[k], keylens[k], vals + k, vallens + k, rank, sid, version);
+            }
+            if (ret == PAPYRUSKV_SLICE_RETRY) deferred.push_back(k);
+            if (epochs) epochs[k] = epoch;
+            rets[k] = ret;
+        }
+        begin = end;
+    }
+
+    for (auto it = deferred.begin(); it != deferred.end(); ++it) {
+        size_t k = *it;
+        rets[k] = ExecuteGet(db, keys[k], keylens[k], vals + k, vallens + k, -1, rank, NULL, epochs ? epochs + k : NULL);
+    }
+    return PAPYRUSKV_OK;
+}
+
+void Dispatcher::ExecuteMigrate(Command* cmd) {
+    return cmd->mt() ? ExecuteMigrateMemTable(cmd) : ExecuteMigrateRemoteBuffer(cmd);
+}
+
+void Dispatcher::ExecuteMigrateRemoteBuffer(Command* cmd) {
+    bool sync = cmd->sync();
+    std::vector<transfer_t> transfers(1);
+    transfers[0].rank = cmd->rank();
+    transfers[0].block = cmd->block();
+    transfers[0].size = cmd->size();
+
+    int ret = Transfer(cmd->dbid(), sync, cmd->level(), transfers, true);
+
+    cmd->Complete(ret);
     if (!sync) Command::Release(cmd);
 }
 
+/* The remote memtable is packed into one or more blocks per destination, in
+ * the remote buffer layout, so each owner acks a block instead of a slice. */
 void Dispatcher::ExecuteMigrateMemTable(Command* cmd) {
     MemTable* mt = cmd->mt();
-    int tag = Tag(cmd->cid());
     bool sync = cmd->sync();
-    for (Slice* slice = mt->SortByKey(); slice; slice = slice->next()) {
+    std::vector<size_t> sizes(nranks_);
+    Slice* head = mt->SortByKey();
+    for (Slice* slice = head; slice; slice = slice->next())
+        sizes[slice->rank()] += RemoteBuffer::EntrySize(slice->keylen(), slice->vallen());
+
+    std::vector<transfer_t> transfers;
+    std::vector<int> open(nranks_, -1);
+    for (Slice* slice = head; slice; slice = slice->next()) {
         _trace("cmd[%lu] dbid[%d] key[%s] keylen[%lu] val[%s] vallen[%lu] tombstone[%d] sync[%d] level[0x%d]", cmd->cid(), cmd->dbid(), slice->key(), slice->keylen(), slice->val(), slice->vallen(), slice->tombstone(), sync, cmd->level());
-        Message msg(PAPYRUSKV_MSG_PUT);
-        msg.WriteULong(cmd->dbid());
-        msg.WriteInt(tag);
-        msg.WriteULong(slice->keylen());
-        msg.WriteULong(slice->vallen());
-        msg.WriteBool(slice->tombstone());
-        msg.WriteBool(sync);
-        msg.Send(slice->rank(), mpi_comm_);
-        MPI_Send(slice->buf(), (int) slice->kvsize(), MPI_CHAR, slice->rank(), tag, mpi_comm_);
-        if (sync) {
-            MPI_Recv(ret_buffer_, 1, MPI_INT, slice->rank(), tag, mpi_comm_ext_, MPI_STATUS_IGNORE);
+        int rank = slice->rank();
+        size_t entry = RemoteBuffer::EntrySize(slice->keylen(), slice->vallen());
+        transfer_t* t = open[rank] == -1 ? NULL : &transfers[open[rank]];
+        if (t == NULL || t->size + entry > PAPYRUSKV_BIG_BUFFER) {
+            transfer_t n;
+            n.rank = rank;
+            n.size = 0UL;
+            size_t capacity = sizes[rank] < PAPYRUSKV_BIG_BUFFER ? sizes[rank] : PAPYRUSKV_BIG_BUFFER;
+            if (posix_memalign((void**) &n.block, 0x10, capacity) != 0) _error("cannot alloc block[%lu]", capacity);
+            open[rank] = (int) transfers.size();
+            transfers.push_back(n);
+            t = &transfers.back();
         }
+        t->size += RemoteBuffer::Pack(t->block + t->size, slice->key(), slice->keylen(), slice->val(), slice->vallen(), slice->tombstone());
+        sizes[rank] -= entry;
     }
 
+    int ret = Transfer(cmd->dbid(), sync, PAPYRUSKV_MEMTABLE, transfers, true);
+
     mt->db()->RemoveRemoteIMT(mt);
     delete mt;
 
-    cmd->Complete();
+    cmd->Complete(ret);
     if (!sync) Command::Release(cmd);
 }
 
 int Dispatcher::ExecuteMigrate(RemoteBuffer* rb, bool sync, int level, int rank) {
-    unsigned long cid = Platform::NewCID();
-    int tag = Tag(cid);
     unsigned long dbid = rb->db()->dbid();
 
     int begin = rank;
@@ -194,21 +318,84 @@ int Dispatcher::ExecuteMigrate(RemoteBuffer* rb, bool sync, int level, int rank)
         end = nranks_;
     }
 
+    std::vector<transfer_t> transfers(end - begin);
     for (int rank = begin; rank < end; rank++) {
-        Message msg(PAPYRUSKV_MSG_MIGRATE);
-        msg.WriteULong(dbid);
-        msg.WriteInt(tag);
-        msg.WriteBool(sync);
-        msg.WriteInt(level);
-        msg.WriteULong(rb->Size(rank));
-        msg.Send(rank, mpi_comm_);
+        transfer_t* t = &transfers[rank - begin];
+        t->rank = rank;
+        t->block = rb->Data(rank);
+        t->size = rb->Size(rank);
+    }
+
+    int ret = Transfer(dbid, sync, level, transfers, false);
 
-        //todo:isend & irecv
-        MPI_Send(rb->Data(rank), (int) rb->Size(rank), MPI_CHAR, rank, tag, mpi_comm_);
-        if (sync) MPI_Recv(ret_buffer_, 1, MPI_INT, rank, tag, mpi_comm_ext_, MPI_STATUS_IGNORE);
-        rb->Reset(rank);
+    for (int rank = begin; rank < end; rank++) rb->Reset(rank);
+    return ret;
+}
+
+/* Posts every block as an MPI_Isend plus an MPI_Irecv for its ack, keeping
+ * at most PAPYRUSKV_MIGRATE_WINDOW transfers in flight, and retires them with
+ * MPI_Waitsome. Blocks to one rank go out in order and the owner's listener
+ * serves one source in order, so they are applied in the order given.
+ * A block for a rank on this node is staged in the shared-memory outbox when
+ * it fits, and the header carries its offset instead of posting the send. */
+int Dispatcher::Transfer(unsigned long dbid, bool sync, int level, std::vector<transfer_t>& transfers, bool release) {
+    int n = (int) transfers.size();
+    int window = n < PAPYRUSKV_MIGRATE_WINDOW ? n : PAPYRUSKV_MIGRATE_WINDOW;
+    if (window == 0) return PAPYRUSKV_OK;
+
+    std::vector<MPI_Request> sends(window, MPI_REQUEST_NULL);
+    std::vector<MPI_Request> acks(window, MPI_REQUEST_NULL);
+    std::vector<int> rets(window);
+    std::vector<int> slots(window);
+    std::vector<int> done(window);
+    std::vector<bool> staged(window);
+    std::vector<int> idle;
+    for (int i = window - 1; i >= 0; i--) idle.push_back(i);
+
+    int ret = PAPYRUSKV_OK;
+    int next = 0;
+    while (next < n || (int) idle.size() < window) {
+        for (; next < n && !idle.empty(); next++) {
+            int slot = idle.back();
+            idle.pop_back();
+            transfer_t* t = &transfers[next];
+            int tag = Tag(Platform::NewCID());
+            _trace("dbid[%lu] tag[%d] rank[%d] size[%lu] sync[%d] level[0x%x]", dbid, tag, t->rank, t->size, sync, level);
+
+            Message msg(PAPYRUSKV_MSG_MIGRATE);
+            msg.WriteULong(dbid);
+            msg.WriteInt(tag);
+            msg.WriteBool(sync);
+            msg.WriteInt(level);
+            msg.WriteULong(t->size);
+
+            uint64_t off = PAPYRUSKV_SHM_NONE;
+            char* outbox = shm_ && shm_->Local(t->rank) ? shm_->Alloc(t->size, &off) : NULL;
+            staged[slot] = outbox != NULL;
+            if (outbox) {
+                memcpy(outbox, t->block, t->size);
+                shm_->Sync();
+            }
+            msg.WriteULong(off);
+            msg.Send(t->rank, mpi_comm_);
+
+            if (!outbox) MPI_Isend(t->block, (int) t->size, MPI_CHAR, t->rank, tag, mpi_comm_, &sends[slot]);
+            MPI_Irecv(&rets[slot], 1, MPI_INT, t->rank, tag, mpi_comm_ext_, &acks[slot]);
+            slots[slot] = next;
+        }
+
+        int count = 0;
+        MPI_Waitsome(window, acks.data(), &count, done.data(), MPI_STATUSES_IGNORE);
+        for (int i = 0; i < count; i++) {
+            int slot = done[i];
+            MPI_Wait(&sends[slot], MPI_STATUS_IGNORE);
+            if (rets[slot] != PAPYRUSKV_OK) ret = rets[slot];
+            if (staged[slot]) shm_->Free();
+            if (release) free(transfers[slots[slot]].block);
+            idle.push_back(slot);
+        }
     }
-    return PAPYRUSKV_OK;
+    return ret;
 }
 
 int Dispatcher::ExecuteSignal(int signum, int* ranks, int count) {
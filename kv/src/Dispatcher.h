@@ -6,12 +6,20 @@
 #include "Message.h"
 #include "Queue.h"
 #include "Pool.h"
+#include "Shm.h"
 #include "Thread.h"
+#include <vector>
 
 namespace papyruskv {
 
 class Platform;
 
+typedef struct {
+    int rank;
+    char* block;
+    size_t size;
+} transfer_t;
+
 class Dispatcher : public Thread {
 public:
     Dispatcher(Platform* platform);
@@ -22,7 +30,10 @@ public:
     void EnqueueWaitRelease(Command* cmd);
 
     int ExecutePut(DB* db, const char* key, size_t keylen, const char* val, size_t vallen, bool tombstone, bool sync, int rank);
-    int ExecuteGet(DB *db, const char* key, size_t keylen, char** valp, size_t* vallenp, int group, int rank, papyruskv_pos_t* pos);
+    int ExecuteGet(DB *db, const char* key, size_t keylen, char** valp, size_t* vallenp, int group, int rank, papyruskv_pos_t* pos, uint64_t* epochp = NULL);
+    int ExecuteIGet(Command* cmd);
+    int CompleteIGet(Command* cmd, uint64_t* epochp = NULL);
+    int ExecuteGetBatch(DB* db, const char** keys, const size_t* keylens, char** vals, size_t* vallens, int* rets, uint64_t* epochs, const std::vector<size_t>& idx, int group, int rank);
     int ExecuteUpdate(DB *db, const char* key, size_t keylen, papyruskv_pos_t* pos, int fnid, void* userin, size_t userinlen, void* userout, size_t useroutlen, int rank);
     int ExecuteMigrate(RemoteBuffer* rb, bool sync, int level, int rank);
     int ExecuteSignal(int signum, int* ranks, int count);
@@ -36,8 +47,10 @@ private:
     void ExecuteCheckpoint(Command* cmd);
     void ExecuteRestart(Command* cmd);
     void ExecuteDistribute(Command* cmd);
+    int Transfer(unsigned long dbid, bool sync, int level, std::vector<transfer_t>& transfers, bool release);
 
-    int Tag(unsigned long cid) { return cid % PAPYRUSKV_MPI_TAG_LIMIT; }
+    /* tag 0 (PAPYRUSKV_MSG_TAG) is reserved for message headers */
+    int Tag(unsigned long cid) { return (int) (cid % (PAPYRUSKV_MPI_TAG_LIMIT - 1)) + 1; }
 
 private:
     virtual void Run();
@@ -46,6 +59,7 @@ private:
     LockFreeQueue<Command*>* queue_;
     Platform* platform_;
     Pool* pool_;
+    Shm* shm_;
     MPI_Comm mpi_comm_;
     MPI_Comm mpi_comm_ext_;
 
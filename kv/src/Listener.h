@@ -4,7 +4,7 @@
 #include <mpi.h>
 #include "Thread.h"
 #include "Message.h"
-#include "Pool.h"
+#include "Worker.h"
 
 namespace papyruskv {
 
@@ -17,30 +17,17 @@ public:
 
     virtual void Stop();
 
-private:
-    void ExecutePut(Message& msg, int rank);
-    void ExecuteGet(Message& msg, int rank);
-    void ExecuteMigrate(Message& msg, int rank);
-    void ExecuteSignal(Message& msg, int rank);
-    void ExecuteBarrier(Message& msg, int rank);
-    void ExecuteUpdate(Message& msg, int rank);
-    void ExecuteExit(Message& msg, int rank);
-
 private:
     virtual void Run();
 
 private:
     Platform* platform_;
     MPI_Comm mpi_comm_;
-    MPI_Comm mpi_comm_ext_;
-    Pool* pool_;
-    char* big_buffer_;
-    int* ret_buffer_;
 
     int rank_;
-    int group_;
 
-    int sleep_usec_;
+    Worker** workers_;
+    int nworkers_;
 };
 
 } /* namespace papyruskv */
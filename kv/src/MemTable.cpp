@@ -10,7 +10,7 @@
 
 namespace papyruskv {
 
-MemTable::MemTable(DB* db, bool local_mt) {
+MemTable::MemTable(DB* db, bool local_mt) : table_(&arena_) {
     if (local_mt) mid_ = Platform::NewMID();
     ref_ = 1;
     db_ = db;
@@ -22,110 +22,74 @@ MemTable::MemTable(DB* db, bool local_mt) {
     bucket_size_ = 0UL;
     next_ = NULL;
     cmd_ = NULL;
-    pthread_mutex_init(&mutex_, NULL);
 }
 
 MemTable::~MemTable() {
-    for (auto it = table_.begin(); it != table_.end(); ++it) delete it->second;
-    pthread_mutex_destroy(&mutex_);
 }
 
-size_t MemTable::Put(Slice* slice) {
-    _trace("key[%s] keylen[%lu] val[%s] vallen[%lu] tombstone[%d]", slice->key(), slice->keylen(), slice->val(), slice->vallen(), slice->tombstone());
-    pthread_mutex_lock(&mutex_);
-    std::string keystr = std::string(slice->key(), slice->keylen());
-    auto old_pair = table_.find(keystr);
-    if (old_pair != table_.end()) {
-        Slice* old = old_pair->second;
-        _trace("key[%s] keylen[%lu] val[%s] vallen[%lu] tombstone[%d]", slice->key(), slice->keylen(), slice->val(), slice->vallen(), slice->tombstone());
-        _trace("key[%s] keylen[%lu] val[%s] vallen[%lu] count[%lu] tombstone[%d]", old->key(), old->keylen(), old->val(), old->vallen(), table_.count(keystr), old->tombstone());
-        if (slice->tombstone() && old->tombstone()) {
-            delete slice;
-        } else if (slice->tombstone() && !old->tombstone()) {
-            old->set_tombstone(true);
-            delete slice;
-        } else {
-            size_ -= old->cb();
-            size_ += old->Update(slice->val(), slice->vallen());
-            delete slice;
-        }
-    } else {
-        _trace("key[%s] size[%lu] tombstone[%d]", slice->key(), slice->cb(), slice->tombstone());
-        table_.insert(std::pair<std::string, Slice*>(keystr, slice));
-        slice->set_mt(this);
-        size_ += slice->cb();
+size_t MemTable::Put(const char* key, size_t keylen, const char* val, size_t vallen, int rank, bool tombstone) {
+    _trace("key[%s] keylen[%lu] val[%s] vallen[%lu] tombstone[%d]", key, keylen, val, vallen, tombstone);
+    if (tombstone) {
+        Slice* old = table_.Get(key, keylen);
+        if (old && old->tombstone()) return size_;
     }
-    pthread_mutex_unlock(&mutex_);
-    return size_;
+    Slice* slice = Slice::Create(&arena_, key, keylen, val, vallen, rank, tombstone);
+    slice->set_mt(this);
+    table_.Put(slice);
+    // replaced slices stay in the arena until the memtable is released, so they remain in size_
+    return __sync_add_and_fetch(&size_, slice->cb());
 }
 
 bool MemTable::Empty() {
-    pthread_mutex_lock(&mutex_);
-    bool empty = table_.empty();
-    pthread_mutex_unlock(&mutex_);
-    return empty;
+    return table_.count() == 0;
 }
 
 int MemTable::Get(const char* key, size_t keylen, char** valp, size_t* vallenp, papyruskv_pos_t* pos) {
-    if (bucket_) return GetHash(key, keylen, valp, vallenp, pos);
-    return GetTable(key, keylen, valp, vallenp, pos);
+    Slice* slice = Lookup(key, keylen);
+    if (slice == NULL) return PAPYRUSKV_SLICE_NOT_FOUND;
+    slice->SetPos(pos);
+    if (slice->tombstone()) return PAPYRUSKV_SLICE_TOMBSTONE;
+    slice->CopyValue(valp, vallenp);
+    return PAPYRUSKV_SLICE_FOUND;
 }
 
-int MemTable::GetHash(const char* key, size_t keylen, char** valp, size_t* vallenp, papyruskv_pos_t* pos) {
-    int idx = BucketIdx(key, keylen);
-    Slice* slice = bucket_[idx];
-    while (slice) {
-        if (slice->Match(key, keylen)) {
-            slice->SetPos(pos);
-            if (slice->tombstone()) return PAPYRUSKV_SLICE_TOMBSTONE;
-            slice->CopyValue(valp, vallenp);
-            return PAPYRUSKV_SLICE_FOUND;
-        }
-        slice = slice->buc_next();
-    }
-    return PAPYRUSKV_SLICE_NOT_FOUND;
+int MemTable::GetView(const char* key, size_t keylen, View* view) {
+    Slice* slice = Lookup(key, keylen);
+    if (slice == NULL) return PAPYRUSKV_SLICE_NOT_FOUND;
+    if (slice->tombstone()) return PAPYRUSKV_SLICE_TOMBSTONE;
+    view->Pin(this, slice);
+    return PAPYRUSKV_SLICE_FOUND;
 }
 
-int MemTable::GetTable(const char* key, size_t keylen, char** valp, size_t* vallenp, papyruskv_pos_t* pos) {
-    std::string keystr = std::string(key, keylen);
-    pthread_mutex_lock(&mutex_);
-    auto it = table_.find(keystr);
-    if (it == table_.end()) {
-        pthread_mutex_unlock(&mutex_);
-        return PAPYRUSKV_SLICE_NOT_FOUND;
-    }
-    Slice* slice = it->second;
-    slice->SetPos(pos);
-    if (slice->tombstone()) {
-        pthread_mutex_unlock(&mutex_);
-        return PAPYRUSKV_SLICE_TOMBSTONE;
-    }
-    slice->CopyValue(valp, vallenp);
-    pthread_mutex_unlock(&mutex_);
-    return PAPYRUSKV_SLICE_FOUND;
+Slice* MemTable::Lookup(const char* key, size_t keylen) {
+    if (bucket_ == NULL) return table_.Get(key, keylen);
+    Slice* slice = bucket_[BucketIdx(key, keylen)];
+    while (slice && !slice->Match(key, keylen)) slice = slice->buc_next();
+    return slice;
 }
 
 Slice* MemTable::SortByKey() {
     head_ = NULL;
     tail_ = NULL;
-    for (auto it = table_.begin(); it != table_.end(); ++it) {
-        Slice* slice = it->second;
+    for (SkipList::Iterator it(&table_); it.Valid(); it.Next()) {
+        Slice* slice = it.slice();
         if (head_ == NULL) head_ = slice;
         if (tail_ != NULL) tail_->set_next(slice);
         tail_ = slice;
     }
+    if (tail_ != NULL) tail_->set_next(NULL);
     return head_;
 }
 
 void MemTable::Hash() {
     ClearBucket();
-    bucket_size_ = hasher_->BucketSize(table_.size());
-    _trace("table[%lu] bucket_size[%lu][%lx]", table_.size(), bucket_size_, bucket_size_);
+    bucket_size_ = hasher_->BucketSize(table_.count());
+    _trace("table[%lu] bucket_size[%lu][%lx]", table_.count(), bucket_size_, bucket_size_);
     bucket_ = new Slice*[bucket_size_];
     for (size_t i = 0; i < bucket_size_; i++) bucket_[i] = NULL;
 
-    for (auto it = table_.begin(); it != table_.end(); ++it) {
-        Slice* slice = it->second;
+    for (SkipList::Iterator it(&table_); it.Valid(); it.Next()) {
+        Slice* slice = it.slice();
         int idx = BucketIdx(slice->key(), slice->keylen());
         if (bucket_[idx] == NULL) bucket_[idx] = slice;
         else {
@@ -140,8 +104,8 @@ void MemTable::ClearBucket() {
     if (bucket_ == NULL) return;
     delete[] bucket_;
     bucket_ = NULL;
-    for (auto it = table_.begin(); it != table_.end(); ++it) {
-        Slice* slice = it->second;
+    for (SkipList::Iterator it(&table_); it.Valid(); it.Next()) {
+        Slice* slice = it.slice();
         slice->set_buc_next(NULL);
     }
 }
@@ -167,9 +131,9 @@ void MemTable::Release(MemTable* mt) {
 }
 
 void MemTable::Print() {
-    if (table_.empty()) _debug("mt[%p], %s", this, "empty");
-    for (auto it = table_.begin(); it != table_.end(); ++it) {
-        Slice* slice = it->second;
+    if (Empty()) _debug("mt[%p], %s", this, "empty");
+    for (SkipList::Iterator it(&table_); it.Valid(); it.Next()) {
+        Slice* slice = it.slice();
         _debug("mt[%p] key[%s] keylen[%lu] val[%s] vallen[%lu]", this, slice->key(), slice->keylen(), slice->val(), slice->vallen());
     }
 }
@@ -177,12 +141,10 @@ void MemTable::Print() {
 MemTable* MemTable::Duplicate(MemTable* mt) {
     MemTable* copy = new MemTable(mt->db_);
     copy->set_mid(mt->mid());
-    pthread_mutex_lock(&mt->mutex_);
-    for (auto it = mt->table_.begin(); it != mt->table_.end(); ++it) {
-        Slice* slice = Slice::Duplicate(it->second);
-        copy->Put(slice);
+    for (SkipList::Iterator it(&mt->table_); it.Valid(); it.Next()) {
+        Slice* slice = it.slice();
+        copy->Put(slice->key(), slice->keylen(), slice->val(), slice->vallen(), slice->rank(), slice->tombstone());
     }
-    pthread_mutex_unlock(&mt->mutex_);
     return copy;
 }
 
@@ -4,9 +4,10 @@
 #include <stddef.h>
 #include <pthread.h>
 #include <semaphore.h>
-#include <map>
-#include <string>
+#include "Arena.h"
 #include "Hasher.h"
+#include "SkipList.h"
+#include "View.h"
 
 namespace papyruskv {
 
@@ -19,10 +20,9 @@ public:
     MemTable(DB* db, bool local_mt = false);
     ~MemTable();
 
-    size_t Put(Slice* slice);
+    size_t Put(const char* key, size_t keylen, const char* val, size_t vallen, int rank, bool tombstone);
     int Get(const char* key, size_t keylen, char** valp, size_t* vallenp, papyruskv_pos_t* pos = NULL);
-    int GetHash(const char* key, size_t keylen, char** valp, size_t* vallenp, papyruskv_pos_t* pos);
-    int GetTable(const char* key, size_t keylen, char** valp, size_t* vallenp, papyruskv_pos_t* pos);
+    int GetView(const char* key, size_t keylen, View* view);
 
     Slice* SortByKey();
     void Hash();
@@ -36,8 +36,10 @@ public:
     unsigned long mid() const { return mid_; }
     void set_mid(unsigned long mid) { mid_ = mid; }
     size_t size() const { return size_; }
-    size_t count() const { return table_.size(); }
+    size_t count() const { return table_.count(); }
     Slice* head() const { return head_; }
+    Slice** bucket() const { return bucket_; }
+    size_t bucket_size() const { return bucket_size_; }
     DB* db() const { return db_; }
     MemTable* next() const { return next_; }
     void set_next(MemTable* mt) { next_ = mt; }
@@ -45,13 +47,15 @@ public:
     void set_cmd(Command* cmd) { cmd_ = cmd; }
 
 private:
+    Slice* Lookup(const char* key, size_t keylen);
     int BucketIdx(const char* key, size_t keylen);
 
 private:
     unsigned long mid_;
     int ref_;
 
-    std::map<std::string, Slice*> table_;
+    Arena arena_;
+    SkipList table_;
 
     size_t size_;
     Slice* head_;
@@ -67,8 +71,6 @@ private:
 
     Command* cmd_;
 
-    pthread_mutex_t mutex_;
-
 public:
     static MemTable* Duplicate(MemTable* mt);
     static void Release(MemTable* mt);
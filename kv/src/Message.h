@@ -19,6 +19,7 @@ namespace papyruskv {
 #define PAPYRUSKV_MSG_SIGNAL    0x2106
 #define PAPYRUSKV_MSG_BARRIER   0x2107
 #define PAPYRUSKV_MSG_UPDATE    0x210c
+#define PAPYRUSKV_MSG_GET_BATCH 0x210d
 #define PAPYRUSKV_MSG_EXIT      0x21ff
 
 class Message {
@@ -39,6 +40,7 @@ public:
     void Write(const void* v, size_t size);
 
     int32_t ReadHeader();
+    int32_t PeekHeader() const { return *(int32_t*) buf_; }
     bool ReadBool();
     int32_t ReadInt();
     uint32_t ReadUInt();
@@ -57,6 +59,8 @@ public:
 
     void Clear();
 
+    int source() const { return status_.MPI_SOURCE; }
+
 private:
     char buf_[PAPYRUSKV_MSG_SIZE] __attribute__ ((aligned(0x10)));
     size_t offset_;
@@ -13,12 +13,16 @@ Platform::Platform() {
 
 Platform::~Platform() {
     if (!init_) return;
-    if (pool_) delete pool_;
     if (signal_) delete signal_;
     if (hasher_) delete hasher_;
     if (dispatcher_) delete dispatcher_;
     if (listener_) delete listener_;
-    if (compactor_) delete compactor_;
+    if (compactors_) {
+        for (int i = 0; i < flush_threads_; i++) delete compactors_[i];
+        delete[] compactors_;
+    }
+    if (shm_) delete shm_;
+    if (pool_) delete pool_;
 
     if (destroy_repository_) Utils::Rmdir(repository_);
 }
@@ -72,9 +76,30 @@ int Platform::Init(int* argc, char*** argv, const char* repository) {
     env = getenv("PAPYRUSKV_CACHE_REMOTE");
     enable_cache_remote_ = env ? atoi(env) > 0 : PAPYRUSKV_CACHE_REMOTE;
 
+    env = getenv("PAPYRUSKV_CACHE_CLOCK");
+    enable_cache_clock_ = env ? atoi(env) > 0 : PAPYRUSKV_CACHE_CLOCK;
+
+    env = getenv("PAPYRUSKV_CACHE_LOCAL_TINYLFU");
+    enable_cache_local_tinylfu_ = env ? atoi(env) > 0 : PAPYRUSKV_CACHE_LOCAL_TINYLFU;
+
+    env = getenv("PAPYRUSKV_CACHE_REMOTE_TINYLFU");
+    enable_cache_remote_tinylfu_ = env ? atoi(env) > 0 : PAPYRUSKV_CACHE_REMOTE_TINYLFU;
+
+    env = getenv("PAPYRUSKV_RMA");
+    enable_rma_ = env ? atoi(env) > 0 : PAPYRUSKV_RMA;
+
+    env = getenv("PAPYRUSKV_DIRECT_IO");
+    enable_direct_io_ = env ? atoi(env) > 0 : PAPYRUSKV_DIRECT_IO;
+
     env = getenv("PAPYRUSKV_BLOOM");
     enable_bloom_ = env ? atoi(env) > 0 : PAPYRUSKV_BLOOM;
 
+    env = getenv("PAPYRUSKV_BLOOM_BLOCKED");
+    enable_bloom_blocked_ = env ? atoi(env) > 0 : PAPYRUSKV_BLOOM_BLOCKED;
+
+    env = getenv("PAPYRUSKV_BLOOM_FPR");
+    bloom_fpr_ = env ? atof(env) : PAPYRUSKV_BLOOM_FPR;
+
     env = getenv("PAPYRUSKV_MEMTABLE_SIZE");
     memtable_size_ = env ? atol(env) : PAPYRUSKV_MEMTABLE_SIZE;
 
@@ -87,6 +112,40 @@ int Platform::Init(int* argc, char*** argv, const char* repository) {
     env = getenv("PAPYRUSKV_CACHE_SIZE");
     cache_size_ = env ? atol(env) : PAPYRUSKV_CACHE_SIZE;
 
+    env = getenv("PAPYRUSKV_CACHE_SHARDS");
+    cache_shards_ = Utils::P2(env && atol(env) > 0 ? atol(env) : PAPYRUSKV_CACHE_SHARDS);
+
+    env = getenv("PAPYRUSKV_CACHE_LEASE");
+    cache_lease_ = env ? atol(env) : PAPYRUSKV_CACHE_LEASE;
+
+    env = getenv("PAPYRUSKV_GET_EAGER");
+    get_eager_ = env ? atol(env) : PAPYRUSKV_GET_EAGER;
+
+    env = getenv("PAPYRUSKV_LISTENER_THREADS");
+    listener_threads_ = env && atoi(env) >= 0 ? atoi(env) : PAPYRUSKV_LISTENER_THREADS;
+
+    env = getenv("PAPYRUSKV_FLUSH_THREADS");
+    flush_threads_ = env && atoi(env) > 0 ? atoi(env) : PAPYRUSKV_FLUSH_THREADS;
+
+    env = getenv("PAPYRUSKV_TABLE_CACHE_SIZE");
+    table_cache_size_ = env ? atol(env) : PAPYRUSKV_TABLE_CACHE_SIZE;
+
+    env = getenv("PAPYRUSKV_POOL_SIZE");
+    pool_size_ = env ? atol(env) : PAPYRUSKV_POOL_SIZE;
+
+    env = getenv("PAPYRUSKV_SHM_SIZE");
+    shm_size_ = env ? atol(env) : PAPYRUSKV_SHM_SIZE;
+
+    env = getenv("PAPYRUSKV_BLOCK_SIZE");
+    block_size_ = env ? atol(env) : PAPYRUSKV_BLOCK_SIZE;
+
+    env = getenv("PAPYRUSKV_COMPACTION");
+    enable_compaction_ = env ? atoi(env) > 0 : PAPYRUSKV_COMPACTION;
+
+    env = getenv("PAPYRUSKV_COMPACTION_TRIGGER");
+    compaction_trigger_ = env ? atol(env) : PAPYRUSKV_COMPACTION_TRIGGER;
+    if (compaction_trigger_ < 2) compaction_trigger_ = 2;
+
     env = getenv("PAPYRUSKV_FORCE_REDISTRIBUTE");
     force_redistribute_ = env ? atoi(env) > 0 : PAPYRUSKV_FORCE_REDISTRIBUTE;
 
@@ -100,21 +159,26 @@ int Platform::Init(int* argc, char*** argv, const char* repository) {
 
     _trace("platform[%s] rank[%d/%d] group[%d]", name_, rank_, size_, group_);
     if (rank_ == 0)
-        _info("PapyrusKV nranks[%d] repository[%s] storage_group[%d] consistency[%x] memtable[%lu] [%lu]MB remotebuf[%lu] [%lu]KB total_remotebuf[%lu] [%lu]MB remotebuf_entry_max[%lu] cache[%lu] [%lu]MB cache_local[%d] cache_remote[%d] sstable[%x] bloom[%d] force_redistribute[%d] destroy_repository[%d]", size_, repository_, group_size, consistency_, memtable_size_, memtable_size_ / 1024 / 1024, remote_buf_size_, remote_buf_size_ / 1024, remote_buf_size_ * size_, remote_buf_size_ * size_ / 1024 / 1024, remote_buf_entry_max_, cache_size_, cache_size_ / 1024 / 1024, enable_cache_local_, enable_cache_remote_, sstable_mode_, enable_bloom_, force_redistribute_, destroy_repository_);
+        _info("PapyrusKV nranks[%d] repository[%s] storage_group[%d] consistency[%x] memtable[%lu] [%lu]MB remotebuf[%lu] [%lu]KB total_remotebuf[%lu] [%lu]MB remotebuf_entry_max[%lu] cache[%lu] [%lu]MB cache_shards[%lu] cache_lease[%lu]us cache_local[%d] cache_remote[%d] cache_clock[%d] cache_tinylfu[%d/%d] table_cache[%lu] [%lu]MB pool[%lu] [%lu]MB shm[%lu] [%lu]MB listener_threads[%d] flush_threads[%d] get_eager[%lu] rma[%d] sstable[%x] direct_io[%d] block[%lu] bloom[%d] bloom_fpr[%lf] bloom_blocked[%d] compaction[%d] trigger[%lu] force_redistribute[%d] destroy_repository[%d]", size_, repository_, group_size, consistency_, memtable_size_, memtable_size_ / 1024 / 1024, remote_buf_size_, remote_buf_size_ / 1024, remote_buf_size_ * size_, remote_buf_size_ * size_ / 1024 / 1024, remote_buf_entry_max_, cache_size_, cache_size_ / 1024 / 1024, cache_shards_, cache_lease_, enable_cache_local_, enable_cache_remote_, enable_cache_clock_, enable_cache_local_tinylfu_, enable_cache_remote_tinylfu_, table_cache_size_, table_cache_size_ / 1024 / 1024, pool_size_, pool_size_ / 1024 / 1024, shm_size_, shm_size_ / 1024 / 1024, listener_threads_, flush_threads_, get_eager_, enable_rma_, sstable_mode_, enable_direct_io_, block_size_, enable_bloom_, bloom_fpr_, enable_bloom_blocked_, enable_compaction_, compaction_trigger_, force_redistribute_, destroy_repository_);
 
     pool_ = new Pool(this);
 
     hasher_ = new Hasher(size_);
-    bloom_ = new Bloom(hasher_, PAPYRUSKV_BLOOM_BITS);
-    
+    bloom_ = new Bloom(hasher_, bloom_fpr_, enable_bloom_blocked_);
+
+    shm_ = shm_size_ ? new Shm(this) : NULL;
+
     dispatcher_ = new Dispatcher(this);
     dispatcher_->Start();
 
     listener_ = new Listener(this);
     listener_->Start();
 
-    compactor_ = new Compactor(this);
-    compactor_->Start();
+    compactors_ = new Compactor*[flush_threads_];
+    for (int i = 0; i < flush_threads_; i++) {
+        compactors_[i] = new Compactor(this);
+        compactors_[i]->Start();
+    }
 
     signal_ = new Signal(this);
 
@@ -148,10 +212,30 @@ int Platform::Put(int dbid, const char* key, size_t keylen, const char* val, siz
     return GetDB(dbid)->Put(key, keylen, val, vallen);
 }
 
+int Platform::PutBatch(int dbid, size_t n, const char** keys, const size_t* keylens, const char** vals, const size_t* vallens) {
+    return GetDB(dbid)->PutBatch(n, keys, keylens, vals, vallens);
+}
+
 int Platform::Get(int dbid, const char* key, size_t keylen, char** val, size_t* vallen, papyruskv_pos_t* pos) {
     return GetDB(dbid)->Get(key, keylen, val, vallen, pos);
 }
 
+int Platform::IGet(int dbid, const char* key, size_t keylen, char** val, size_t* vallen, int* event) {
+    return GetDB(dbid)->IGet(key, keylen, val, vallen, event);
+}
+
+int Platform::GetBatch(int dbid, size_t n, const char** keys, const size_t* keylens, char** vals, size_t* vallens, int* rets) {
+    return GetDB(dbid)->GetBatch(n, keys, keylens, vals, vallens, rets);
+}
+
+int Platform::GetView(int dbid, const char* key, size_t keylen, const char** val, size_t* vallen, papyruskv_view_t* view) {
+    return GetDB(dbid)->GetView(key, keylen, val, vallen, (View**) view);
+}
+
+int Platform::ReleaseView(int dbid, papyruskv_view_t view) {
+    return GetDB(dbid)->ReleaseView((View*) view);
+}
+
 int Platform::Delete(int dbid, const char* key, size_t keylen) {
     return GetDB(dbid)->Delete(key, keylen);
 }
@@ -216,6 +300,19 @@ int Platform::Wait(int dbid, int event) {
     return GetDB(dbid)->Wait(event);
 }
 
+int Platform::Test(int dbid, int event, int* flag) {
+    return GetDB(dbid)->Test(event, flag);
+}
+
+int Platform::CacheStat(int dbid, papyruskv_cache_stat_t* local, papyruskv_cache_stat_t* remote) {
+    return GetDB(dbid)->CacheStat(local, remote);
+}
+
+int Platform::PoolStat(papyruskv_pool_stat_t* stat) {
+    pool_->Stat(stat);
+    return PAPYRUSKV_OK;
+}
+
 int Platform::Hash(int dbid) {
     return GetDB(dbid)->Hash();
 }
@@ -228,6 +325,10 @@ int Platform::IterNext(int dbid, papyruskv_iter_t* iter) {
     return GetDB(dbid)->IterNext(iter);
 }
 
+int Platform::IterFree(int dbid, papyruskv_iter_t* iter) {
+    return GetDB(dbid)->IterFree(iter);
+}
+
 int Platform::RegisterUpdate(int dbid, int fnid, papyruskv_update_fn_t ufn) {
     return GetDB(dbid)->RegisterUpdate(fnid, ufn);
 }
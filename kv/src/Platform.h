@@ -7,6 +7,7 @@
 #include "Compactor.h"
 #include "Dispatcher.h"
 #include "Listener.h"
+#include "Shm.h"
 #include "Signal.h"
 #include "Pool.h"
 #include "Bloom.h"
@@ -24,7 +25,12 @@ public:
     int Open(const char* name, int flags, papyruskv_option_t* opt, int* dbid);
     int Close(int dbid);
     int Put(int dbid, const char* key, size_t keylen, const char* val, size_t vallen);
+    int PutBatch(int dbid, size_t n, const char** keys, const size_t* keylens, const char** vals, const size_t* vallens);
+    int IGet(int dbid, const char* key, size_t keylen, char** val, size_t* vallen, int* event);
     int Get(int dbid, const char* key, size_t keylen, char** val, size_t* vallen, papyruskv_pos_t* pos);
+    int GetBatch(int dbid, size_t n, const char** keys, const size_t* keylens, char** vals, size_t* vallens, int* rets);
+    int GetView(int dbid, const char* key, size_t keylen, const char** val, size_t* vallen, papyruskv_view_t* view);
+    int ReleaseView(int dbid, papyruskv_view_t view);
     int Delete(int dbid, const char* key, size_t keylen);
     int Free(char** val);
     int Fence(int dbid, int level);
@@ -37,10 +43,14 @@ public:
     int Restart(const char* path, const char* name, int prot, papyruskv_option_t* opt, int* dbid, int* event);
     int Destroy(int dbid, int* event);
     int Wait(int dbid, int event);
+    int Test(int dbid, int event, int* flag);
+    int CacheStat(int dbid, papyruskv_cache_stat_t* local, papyruskv_cache_stat_t* remote);
+    int PoolStat(papyruskv_pool_stat_t* stat);
 
     int Hash(int dbid);
     int IterLocal(int dbid, papyruskv_iter_t* iter);
     int IterNext(int dbid, papyruskv_iter_t* iter);
+    int IterFree(int dbid, papyruskv_iter_t* iter);
     int RegisterUpdate(int dbid, int fnid, papyruskv_update_fn_t ufn);
     int Update(int dbid, const char* key, size_t keylen, papyruskv_pos_t* pos, int fnid, void* userin, size_t userinlen, void* userout, size_t useroutlen);
 
@@ -53,21 +63,38 @@ public:
     const char* repository() const { return repository_; }
 
     DB* GetDB(int dbid);
-    Compactor* compactor() { return compactor_; }
+    Compactor* compactor(unsigned long dbid) { return compactors_[dbid % flush_threads_]; }
     Dispatcher* dispatcher() { return dispatcher_; }
     Pool* pool() { return pool_; }
     Hasher* hasher() { return hasher_; }
     Bloom* bloom() { return bloom_; }
     Signal* signal() { return signal_; }
+    Shm* shm() { return shm_; }
 
     int consistency() const { return consistency_; }
     size_t memtable_size() const { return memtable_size_; }
     size_t remote_buf_size() const { return remote_buf_size_; }
     size_t remote_buf_entry_max() const { return remote_buf_entry_max_; }
     size_t cache_size() const { return cache_size_; }
+    size_t cache_shards() const { return cache_shards_; }
+    size_t cache_lease() const { return cache_lease_; }
+    size_t table_cache_size() const { return table_cache_size_; }
+    size_t pool_size() const { return pool_size_; }
+    size_t shm_size() const { return shm_size_; }
+    size_t block_size() const { return block_size_; }
+    int listener_threads() const { return listener_threads_; }
+    int flush_threads() const { return flush_threads_; }
+    size_t get_eager() const { return get_eager_; }
     bool enable_cache_local() const { return enable_cache_local_; }
     bool enable_cache_remote() const { return enable_cache_remote_; }
+    bool enable_cache_clock() const { return enable_cache_clock_; }
+    bool enable_cache_local_tinylfu() const { return enable_cache_local_tinylfu_; }
+    bool enable_cache_remote_tinylfu() const { return enable_cache_remote_tinylfu_; }
+    bool enable_rma() const { return enable_rma_; }
+    bool enable_direct_io() const { return enable_direct_io_; }
     bool enable_bloom() const { return enable_bloom_; }
+    bool enable_compaction() const { return enable_compaction_; }
+    size_t compaction_trigger() const { return compaction_trigger_; }
     bool force_redistribute() const { return force_redistribute_; }
 
     void set_umid(unsigned long mid) { umid_ = mid; }
@@ -88,23 +115,42 @@ private:
     char repository_rank_[256];
 
     DB* db_[PAPYRUSKV_MAX_DB];
-    Compactor* compactor_;
+    Compactor** compactors_;
     Dispatcher* dispatcher_;
     Listener* listener_;
     Pool* pool_;
     Hasher* hasher_;
     Bloom* bloom_;
     Signal* signal_;
+    Shm* shm_;
 
     size_t memtable_size_;
     size_t remote_buf_size_;
     size_t remote_buf_entry_max_;
     size_t cache_size_;
+    size_t cache_shards_;
+    size_t cache_lease_;
+    size_t table_cache_size_;
+    size_t pool_size_;
+    size_t shm_size_;
+    size_t block_size_;
+    size_t get_eager_;
+    double bloom_fpr_;
+    size_t compaction_trigger_;
     int consistency_;
     int sstable_mode_;
+    int listener_threads_;
+    int flush_threads_;
     bool enable_cache_local_;
     bool enable_cache_remote_;
+    bool enable_cache_clock_;
+    bool enable_cache_local_tinylfu_;
+    bool enable_cache_remote_tinylfu_;
+    bool enable_rma_;
+    bool enable_direct_io_;
     bool enable_bloom_;
+    bool enable_bloom_blocked_;
+    bool enable_compaction_;
     bool force_redistribute_;
     bool destroy_repository_;
 
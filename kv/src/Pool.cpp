@@ -1,22 +1,143 @@
 #include "Pool.h"
+#include "Platform.h"
 #include "Debug.h"
+#include <stdlib.h>
+#include <string.h>
 
 namespace papyruskv {
 
+static Pool* instance_;
+static unsigned long generation_;
+static __thread void* tcache_;
+static __thread unsigned long tcache_generation_;
+
 Pool::Pool(Platform* platform) {
     platform_ = platform;
+    fixed_ = 0UL;
+    capacity_ = platform->pool_size();
+    memset(&retired_, 0, sizeof(retired_));
+    pthread_mutex_init(&mutex_, NULL);
+    pthread_key_create(&key_, ReleaseCache);
+    instance_ = this;
+    generation_++;
 }
 
 Pool::~Pool() {
+    papyruskv_pool_stat_t stat;
+    Stat(&stat);
+    if (stat.hits + stat.misses)
+        _trace("hit[%lu] miss[%lu] hitratio[%lf] large[%lu] free[%lu]", stat.hits, stat.misses, (double) (stat.hits) / (stat.hits + stat.misses), stat.large, stat.frees);
+
+    /* caches of threads that are still alive, including this one */
+    while (!caches_.empty()) ReleaseCache(caches_.front());
+    tcache_ = NULL;
+    instance_ = NULL;
+    pthread_key_delete(key_);
+    pthread_mutex_destroy(&mutex_);
+}
+
+void Pool::SetFixed(size_t vallen) {
+    /* the fixed class is bound once; blocks already cached under it keep their size */
+    if (fixed_ == 0UL) fixed_ = vallen;
+}
+
+int Pool::Class(size_t vallen) const {
+    if (fixed_ && vallen == fixed_) return PAPYRUSKV_POOL_FIXED;
+    if (vallen > (1UL << PAPYRUSKV_POOL_MAX_SHIFT)) return PAPYRUSKV_POOL_LARGE;
+    if (vallen <= (1UL << PAPYRUSKV_POOL_MIN_SHIFT)) return 0;
+    return 64 - __builtin_clzl(vallen - 1) - PAPYRUSKV_POOL_MIN_SHIFT;
+}
+
+size_t Pool::ClassSize(int cls) const {
+    return cls == PAPYRUSKV_POOL_FIXED ? fixed_ : 1UL << (cls + PAPYRUSKV_POOL_MIN_SHIFT);
+}
+
+Pool::ThreadCache* Pool::Cache() {
+    ThreadCache* cache = (ThreadCache*) tcache_;
+    if (cache && tcache_generation_ == generation_) return cache;
+    cache = new ThreadCache;
+    memset(cache, 0, sizeof(ThreadCache));
+    pthread_mutex_lock(&mutex_);
+    caches_.push_back(cache);
+    pthread_mutex_unlock(&mutex_);
+    pthread_setspecific(key_, cache);
+    tcache_ = cache;
+    tcache_generation_ = generation_;
+    return cache;
+}
+
+void Pool::ReleaseCache(void* arg) {
+    ThreadCache* cache = (ThreadCache*) arg;
+    for (int i = 0; i < PAPYRUSKV_POOL_CLASSES; i++) {
+        while (cache->heads[i]) {
+            pool_header_t* h = cache->heads[i];
+            cache->heads[i] = h->next;
+            free(h);
+        }
+    }
+    if (instance_) {
+        pthread_mutex_lock(&instance_->mutex_);
+        instance_->retired_.hits += cache->stat.hits;
+        instance_->retired_.misses += cache->stat.misses;
+        instance_->retired_.large += cache->stat.large;
+        instance_->retired_.frees += cache->stat.frees;
+        instance_->caches_.remove(cache);
+        pthread_mutex_unlock(&instance_->mutex_);
+    }
+    if (tcache_ == cache) tcache_ = NULL;
+    delete cache;
 }
 
 char* Pool::AllocVal(size_t vallen) {
-    return new char[vallen];
+    int cls = Class(vallen);
+    ThreadCache* cache = Cache();
+    pool_header_t* h;
+    if (cls == PAPYRUSKV_POOL_LARGE) {
+        cache->stat.large++;
+        h = (pool_header_t*) malloc(sizeof(pool_header_t) + vallen);
+    } else if (cache->heads[cls]) {
+        cache->stat.hits++;
+        h = cache->heads[cls];
+        cache->heads[cls] = h->next;
+        cache->bytes -= ClassSize(cls);
+    } else {
+        cache->stat.misses++;
+        h = (pool_header_t*) malloc(sizeof(pool_header_t) + ClassSize(cls));
+    }
+    if (h == NULL) {
+        _error("cannot alloc vallen[%lu]", vallen);
+        return NULL;
+    }
+    h->cls = cls;
+    return (char*) (h + 1);
 }
 
 void Pool::FreeVal(char** val) {
-    delete[] *val;
+    if (*val == NULL) return;
+    pool_header_t* h = ((pool_header_t*) *val) - 1;
     *val = NULL;
+    ThreadCache* cache = Cache();
+    cache->stat.frees++;
+    int cls = (int) h->cls;
+    if (cls == PAPYRUSKV_POOL_LARGE || cache->bytes + ClassSize(cls) > capacity_) {
+        free(h);
+        return;
+    }
+    h->next = cache->heads[cls];
+    cache->heads[cls] = h;
+    cache->bytes += ClassSize(cls);
+}
+
+void Pool::Stat(papyruskv_pool_stat_t* stat) {
+    pthread_mutex_lock(&mutex_);
+    *stat = retired_;
+    for (auto it = caches_.begin(); it != caches_.end(); ++it) {
+        stat->hits += (*it)->stat.hits;
+        stat->misses += (*it)->stat.misses;
+        stat->large += (*it)->stat.large;
+        stat->frees += (*it)->stat.frees;
+    }
+    pthread_mutex_unlock(&mutex_);
 }
 
 } /* namespace papyruskv */
@@ -1,12 +1,27 @@
 #ifndef PAPYRUS_KV_SRC_POOL_H
 #define PAPYRUS_KV_SRC_POOL_H
 
+#include <papyrus/kv.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <list>
+
+#define PAPYRUSKV_POOL_MIN_SHIFT    4
+#define PAPYRUSKV_POOL_MAX_SHIFT    20
+#define PAPYRUSKV_POOL_CLASSES      (PAPYRUSKV_POOL_MAX_SHIFT - PAPYRUSKV_POOL_MIN_SHIFT + 2)
+#define PAPYRUSKV_POOL_FIXED        (PAPYRUSKV_POOL_CLASSES - 1)
+#define PAPYRUSKV_POOL_LARGE        0xff
 
 namespace papyruskv {
 
 class Platform;
 
+typedef struct _pool_header_t {
+    uint64_t cls;
+    struct _pool_header_t* next;
+} pool_header_t;
+
 class Pool {
 public:
     Pool(Platform* platform);
@@ -15,8 +30,31 @@ public:
     char* AllocVal(size_t vallen);
     void FreeVal(char** val);
 
+    void SetFixed(size_t vallen);
+    void Stat(papyruskv_pool_stat_t* stat);
+
+private:
+    struct ThreadCache {
+        pool_header_t* heads[PAPYRUSKV_POOL_CLASSES];
+        size_t bytes;
+        papyruskv_pool_stat_t stat;
+    };
+
+    int Class(size_t vallen) const;
+    size_t ClassSize(int cls) const;
+    ThreadCache* Cache();
+
+    static void ReleaseCache(void* arg);
+
 private:
     Platform* platform_;
+    size_t fixed_;
+    size_t capacity_;
+
+    pthread_key_t key_;
+    pthread_mutex_t mutex_;
+    std::list<ThreadCache*> caches_;
+    papyruskv_pool_stat_t retired_;
 };
 
 } /* namespace papyruskv */
@@ -21,26 +21,30 @@ RemoteBuffer::~RemoteBuffer() {
 }
 
 bool RemoteBuffer::Available(size_t keylen, size_t vallen, int rank) {
-    return off_[rank] + keylen + vallen + 1 <= unit_;
+    return off_[rank] + EntrySize(keylen, vallen) <= unit_;
 }
 
 int RemoteBuffer::Put(const char* key, size_t keylen, const char* val, size_t vallen, bool tombstone, int rank) {
-    size_t off = rank * unit_ + off_[rank];
-    memcpy(buf_ + off, &keylen, sizeof(size_t));
+    off_[rank] += Pack(buf_ + rank * unit_ + off_[rank], key, keylen, val, vallen, tombstone);
+    _trace("key[%s] keylen[%lu] val[%s] vallen[%lu] rank[%d] off[%lu]", key, keylen, val, vallen, rank, off_[rank]);
+    return PAPYRUSKV_OK;
+}
+
+size_t RemoteBuffer::Pack(char* dst, const char* key, size_t keylen, const char* val, size_t vallen, bool tombstone) {
+    size_t off = 0UL;
+    memcpy(dst + off, &keylen, sizeof(size_t));
     off += sizeof(size_t);
-    memcpy(buf_ + off, &vallen, sizeof(size_t));
+    memcpy(dst + off, &vallen, sizeof(size_t));
     off += sizeof(size_t);
-    memcpy(buf_ + off, key, keylen);
+    memcpy(dst + off, key, keylen);
     off += keylen;
     if (vallen > 0) {
-        memcpy(buf_ + off, val, vallen);
+        memcpy(dst + off, val, vallen);
         off += vallen;
     }
-    buf_[off] = tombstone ? (char) 1 : (char) 0;
+    dst[off] = tombstone ? (char) 1 : (char) 0;
     off += 1;
-    off_[rank] += 2 * sizeof(size_t) + keylen + vallen + 1;
-    _trace("key[%s] keylen[%lu] val[%s] vallen[%lu] rank[%d] off[%lu]", key, keylen, val, vallen, rank, off_[rank]);
-    return PAPYRUSKV_OK;
+    return off;
 }
 
 char* RemoteBuffer::Data(int rank) {
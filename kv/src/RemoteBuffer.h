@@ -1,6 +1,8 @@
 #ifndef PAPYRUS_KV_SRC_REMOTEBUFFER_H
 #define PAPYRUS_KV_SRC_REMOTEBUFFER_H
 
+#include <stddef.h>
+
 namespace papyruskv {
 
 class DB;
@@ -19,6 +21,9 @@ public:
 
     DB* db() const { return db_; }
 
+    static size_t EntrySize(size_t keylen, size_t vallen) { return 2 * sizeof(size_t) + keylen + vallen + 1; }
+    static size_t Pack(char* dst, const char* key, size_t keylen, const char* val, size_t vallen, bool tombstone);
+
 private:
     DB* db_;
     char* buf_;
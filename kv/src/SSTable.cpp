@@ -4,9 +4,13 @@
 #include "Debug.h"
 #include "Slice.h"
 #include "Utils.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <sys/mman.h>
 #include <sys/sendfile.h>
 
 namespace papyruskv {
@@ -17,140 +21,285 @@ SSTable::SSTable(DB* db, int mode) {
     nranks_ = db->nranks();
     group_ = db->group();
     sid_ = 0ULL;
+    version_ = 0ULL;
     mode_ = mode;
     bloom_ = db->platform()->bloom();
     enable_bloom_ = db->platform()->enable_bloom();
+    block_size_ = db->platform()->block_size();
+    enable_compaction_ = db->platform()->enable_compaction();
+    direct_io_ = db->platform()->enable_direct_io();
+    compaction_trigger_ = db->platform()->compaction_trigger();
+    compaction_base_ = compaction_trigger_ * db->platform()->memtable_size();
+    pins_ = 0;
     pool_ = db->platform()->pool();
     sprintf(root_, "%s", db->platform()->repository());
+    table_cache_ = new TableCache(this, db->platform()->table_cache_size());
     pthread_mutex_init(&mutex_, NULL);
+    pthread_rwlock_init(&rwlock_tables_, NULL);
+    pthread_rwlock_init(&rwlock_peers_, NULL);
+    peers_.resize(nranks_);
+    for (auto it = peers_.begin(); it != peers_.end(); ++it) it->version = 0ULL;
 }
 
 SSTable::~SSTable() {
+    delete table_cache_;
     pthread_mutex_destroy(&mutex_);
+    pthread_rwlock_destroy(&rwlock_tables_);
+    pthread_rwlock_destroy(&rwlock_peers_);
 }
 
 uint64_t SSTable::Flush(MemTable* mt) {
     pthread_mutex_lock(&mutex_);
-    char path[256];
+    char idx_path[256];
+    char sst_path[256];
+    char blm_path[256];
 
     uint64_t sid = mt->mid();
 
-    GetIDXPath(0, rank_, sid, root_, path);
-    int fd_idx = open(path, O_CREAT | O_WRONLY, S_IRUSR | S_IWUSR);
-    if (fd_idx == -1) _error("path[%s]", path);
-
-    GetSSTPath(0, rank_, sid, root_, path);
-    int fd_sst = open(path, O_CREAT | O_WRONLY, S_IRUSR | S_IWUSR);
-    if (fd_sst == -1) _error("path[%s]", path);
+    GetIDXPath(0, rank_, sid, root_, idx_path);
+    GetSSTPath(0, rank_, sid, root_, sst_path);
+    GetBLMPath(0, rank_, sid, root_, blm_path);
 
-    uint64_t idx = 0;
+    TableBuilder builder(idx_path, sst_path, enable_bloom_ ? blm_path : NULL, bloom_, mt->count(), block_size_, direct_io_);
     for (Slice* slice = mt->head(); slice; slice = slice->next()) {
-        slice_idx_t si = (slice_idx_t) { idx, slice->keylen(), slice->tombstone() ? (uint8_t) 1 : (uint8_t) 0 };
-        ssize_t ssret = write(fd_idx, &si, sizeof(si));
-        if (ssret != sizeof(si)) _error("ret[%ld] size[%lu]", ssret, sizeof(si));
-        _trace("idx[%lu] len[%lu] tombstone[%d]", si.idx, si.len, si.tombstone);
-
-        size_t kvsize = slice->kvsize();
-        _trace("fd[%d] path[%s] key[%s] keylen[%lu] val[%s] vallen[%lu] kvsize[%lu] tombstone[%d]", fd_sst, path, slice->key(), slice->keylen(), slice->val(), slice->vallen(), kvsize, slice->tombstone());
-        ssret = write(fd_sst, slice->buf(), kvsize);
-        if (ssret != kvsize) _error("ret[%ld] kvsize[%lu]", ssret, kvsize);
-
-        idx += kvsize;
-    }
-
-    if (enable_bloom_) {
-        GetBLMPath(0, rank_, sid, root_, path);
-        int fd_blm = open(path, O_CREAT | O_WRONLY, S_IRUSR | S_IWUSR);
-        if (fd_blm == -1) _error("path[%s]", path);
-        size_t bitslen = bloom_->len();
-        uint64_t* bits = bloom_->Bits(mt->head());
-        ssize_t ssret = write(fd_blm, bits, sizeof(uint64_t) * bitslen);
-        if (ssret != sizeof(uint64_t) * bitslen) _error("ret[%ld] size[%lu]", ssret, sizeof(uint64_t) * bitslen);
-        delete[] bits;
-        int iret = close(fd_blm);
-        if (iret == -1) _error("ret[%d]", iret);
+        _trace("key[%s] keylen[%lu] val[%s] vallen[%lu] tombstone[%d]", slice->key(), slice->keylen(), slice->val(), slice->vallen(), slice->tombstone());
+        builder.Add(slice->key(), slice->keylen(), slice->val(), slice->vallen(), slice->tombstone());
     }
+    if (!builder.Finish()) _error("sid[%lu] path[%s]", sid, sst_path);
 
-    int iret = close(fd_idx);
-    if (iret == -1) _error("ret[%d]", iret);
-    iret = close(fd_sst);
-    if (iret == -1) _error("ret[%d]", iret);
+    table_meta_t meta = { 0, sid, builder.count(), builder.size(), builder.min_key(), builder.max_key() };
 
+    char path[256];
+    GetMFTPath(rank_, root_, path);
+    pthread_rwlock_wrlock(&rwlock_tables_);
+    tables_.insert(tables_.begin(), meta);
     sid_ = sid;
+    PublishManifest(path);
+    pthread_rwlock_unlock(&rwlock_tables_);
+
     pthread_mutex_unlock(&mutex_);
 
     return sid_;
 }
 
 int SSTable::Get(const char* key, size_t keylen, char** valp, size_t* vallenp) {
-    pthread_mutex_lock(&mutex_);
-    uint64_t sid = sid_;
-    pthread_mutex_unlock(&mutex_);
-    return Get(key, keylen, valp, vallenp, rank_, sid);
+    pthread_rwlock_rdlock(&rwlock_tables_);
+    int ret = Search(key, keylen, valp, vallenp, rank_, tables_);
+    pthread_rwlock_unlock(&rwlock_tables_);
+    return ret == PAPYRUSKV_SLICE_RETRY ? PAPYRUSKV_SLICE_NOT_FOUND : ret;
+}
+
+int SSTable::GetView(const char* key, size_t keylen, View* view) {
+    pthread_rwlock_rdlock(&rwlock_tables_);
+    int ret = Search(key, keylen, NULL, NULL, rank_, tables_, view);
+    pthread_rwlock_unlock(&rwlock_tables_);
+    return ret == PAPYRUSKV_SLICE_RETRY ? PAPYRUSKV_SLICE_NOT_FOUND : ret;
 }
 
-int SSTable::Get(const char* key, size_t keylen, char** valp, size_t* vallenp, int rank, int sid) {
+/* Reads a group peer's tables directly. The peer's manifest is only reread
+ * when the version the owner reported has moved past the cached one, and its
+ * table readers stay in the table cache across versions. */
+int SSTable::Get(const char* key, size_t keylen, char** valp, size_t* vallenp, int rank, int sid, uint64_t version) {
+    if (rank == rank_) return Get(key, keylen, valp, vallenp);
     if (sid == 0) return PAPYRUSKV_SLICE_NOT_FOUND;
-    int ret = PAPYRUSKV_SLICE_NOT_FOUND;
-    //TODO: outer-loop for levels
-    for (uint64_t i = sid; ret == PAPYRUSKV_SLICE_NOT_FOUND && i > 0; i--) {
-        char path[256];
 
-        if (enable_bloom_) {
-            GetBLMPath(0, rank, i, root_, path);
-            int fd_blm = open(path, O_RDONLY);
-            if (fd_blm == -1) { _error("path[%s]", path);
-            } else {
-                off_t fd_blm_size = lseek(fd_blm, 0, SEEK_END);
-                size_t bitslen = fd_blm_size / sizeof(uint64_t);
-                uint64_t* bits = new uint64_t[bitslen];
-                ssize_t ssret = pread(fd_blm, bits, fd_blm_size, 0);
-                if (ssret != fd_blm_size) _error("ret[%ld] size[%ld", ssret, fd_blm_size);
-                int iret = close(fd_blm);
-                if (iret != 0) _error("fd[%d] ret[%d]", fd_blm, iret);
-                bool maybe = bloom_->Maybe(key, keylen, bits, bitslen);
-                delete[] bits;
-                if (!maybe) continue;
-            }
+    pthread_rwlock_rdlock(&rwlock_peers_);
+    peer_manifest_t* peer = &peers_[rank];
+    if (version && peer->version == version) {
+        int ret = Search(key, keylen, valp, vallenp, rank, peer->tables);
+        pthread_rwlock_unlock(&rwlock_peers_);
+        return ret;
+    }
+    pthread_rwlock_unlock(&rwlock_peers_);
+
+    char path[256];
+    GetMFTPath(rank, root_, path);
+    std::vector<table_meta_t> tables;
+    bool manifest = ReadManifest(&tables, path);
+    if (!manifest) {
+        tables.clear();
+        for (uint64_t i = sid; i > 0; i--) {
+            table_meta_t meta = {};
+            meta.sid = i;
+            tables.push_back(meta);
         }
+    }
+    int ret = Search(key, keylen, valp, vallenp, rank, tables);
+    /* the manifest on disk is at least as new as the version reported */
+    if (version && manifest) UpdatePeer(rank, version, tables);
+    return ret;
+}
 
-        GetIDXPath(0, rank, i, root_, path);
-        int fd_idx = open(path, O_RDONLY);
-        if (fd_idx == -1) {
-            _error("path[%s]", path);
-            break;
+/* Replaces the cached manifest of a peer and drops the readers of tables the
+ * peer has compacted away since. */
+void SSTable::UpdatePeer(int rank, uint64_t version, std::vector<table_meta_t>& tables) {
+    pthread_rwlock_wrlock(&rwlock_peers_);
+    peer_manifest_t* peer = &peers_[rank];
+    if (version > peer->version) {
+        for (auto old = peer->tables.begin(); old != peer->tables.end(); ++old) {
+            bool live = false;
+            for (auto it = tables.begin(); !live && it != tables.end(); ++it)
+                live = it->level == old->level && it->sid == old->sid;
+            if (!live) table_cache_->Evict(rank, old->level, old->sid);
         }
-        GetSSTPath(0, rank, i, root_, path);
-        int fd_sst = open(path, O_RDONLY);
-        if (fd_sst == -1) {
-            _error("path[%s]", path);
-            break;
+        peer->version = version;
+        peer->tables.swap(tables);
+    }
+    pthread_rwlock_unlock(&rwlock_peers_);
+}
+
+int SSTable::Search(const char* key, size_t keylen, char** valp, size_t* vallenp, int rank, std::vector<table_meta_t>& tables, View* view) {
+    int ret = PAPYRUSKV_SLICE_NOT_FOUND;
+    for (auto it = tables.begin(); ret == PAPYRUSKV_SLICE_NOT_FOUND && it != tables.end(); ++it) {
+        if (!it->max.empty() &&
+                (Utils::Compare(key, keylen, it->min.data(), it->min.size()) < 0 ||
+                 Utils::Compare(key, keylen, it->max.data(), it->max.size()) > 0)) continue;
+
+        Table* table = table_cache_->Get(rank, it->level, it->sid);
+        if (table == NULL) return PAPYRUSKV_SLICE_RETRY;
+
+        if (table->count() == 0 || (enable_bloom_ && table->bits() &&
+                    !bloom_->Maybe(key, keylen, table->bits(), table->bitslen()))) {
+            table_cache_->Release(table);
+            continue;
+        }
+
+        if (table->blocked()) ret = GetBlock(key, keylen, valp, vallenp, table, view);
+        else if (mode_ & PAPYRUSKV_SSTABLE_SEQ) ret = GetSequential(key, keylen, valp, vallenp, table, view);
+        else ret = GetBinary(key, keylen, valp, vallenp, table, view);
+
+        table_cache_->Release(table);
+    }
+
+    return ret;
+}
+
+Table* SSTable::OpenTable(int rank, int level, uint64_t sid) {
+    char idx_path[256];
+    char sst_path[256];
+    char blm_path[256];
+    GetIDXPath(level, rank, sid, root_, idx_path);
+    GetSSTPath(level, rank, sid, root_, sst_path);
+    GetBLMPath(level, rank, sid, root_, blm_path);
+    return OpenTable(rank, level, sid, idx_path, sst_path, enable_bloom_ ? blm_path : NULL);
+}
+
+Table* SSTable::OpenTable(int rank, int level, uint64_t sid, const char* idx_path, const char* sst_path, const char* blm_path) {
+    /* A peer's table can disappear under a compaction; the caller retries. */
+    bool quiet = rank != rank_;
+
+    uint64_t* bits = NULL;
+    size_t bitslen = 0UL;
+    int fd_blm = blm_path ? open(blm_path, O_RDONLY) : -1;
+    if (fd_blm != -1) {
+        bits = bloom_->Read(fd_blm, &bitslen);
+        int iret = close(fd_blm);
+        if (iret != 0) _error("fd[%d] ret[%d]", fd_blm, iret);
+    }
+
+    int fd_sst = open(sst_path, O_RDONLY);
+    if (fd_sst == -1) {
+        if (!quiet) _error("path[%s]", sst_path);
+        if (bits) free(bits);
+        return NULL;
+    }
+    off_t fd_sst_size = lseek(fd_sst, 0, SEEK_END);
+
+    table_footer_t footer;
+    if (fd_sst_size >= (off_t) sizeof(footer) &&
+            pread(fd_sst, &footer, sizeof(footer), fd_sst_size - sizeof(footer)) == sizeof(footer) &&
+            footer.magic == PAPYRUSKV_TABLE_MAGIC && footer.version == PAPYRUSKV_TABLE_VERSION)
+        return OpenTable(rank, level, sid, fd_sst, fd_sst_size, &footer, bits, bitslen);
+
+    int fd_idx = open(idx_path, O_RDONLY);
+    if (fd_idx == -1) {
+        if (!quiet) _error("path[%s]", idx_path);
+        if (bits) free(bits);
+        close(fd_sst);
+        return NULL;
+    }
+    off_t fd_idx_size = lseek(fd_idx, 0, SEEK_END);
+    _trace("fd_idx_size[%lu] fd_sst_size[%lu]", fd_idx_size, fd_sst_size);
+    size_t idx_cnt = fd_idx_size / sizeof(slice_idx_t);
+
+    if ((mode_ & PAPYRUSKV_SSTABLE_MMAP) && fd_idx_size > 0 && fd_sst_size > 0) {
+        void* idx_map = mmap(NULL, fd_idx_size, PROT_READ, MAP_SHARED, fd_idx, 0);
+        void* sst_map = mmap(NULL, fd_sst_size, PROT_READ, MAP_SHARED, fd_sst, 0);
+        if (idx_map != MAP_FAILED && sst_map != MAP_FAILED) {
+            int iret = close(fd_idx);
+            if (iret != 0) _error("fd[%d] ret[%d]", fd_idx, iret);
+            return new Table(rank, level, sid, fd_sst, fd_sst_size, (char*) sst_map, (slice_idx_t*) idx_map, idx_cnt, bits, bitslen);
         }
-        off_t fd_idx_size = lseek(fd_idx, 0, SEEK_END);
-        off_t fd_sst_size = lseek(fd_sst, 0, SEEK_END);
-        _trace("fd_idx_size[%lu] fd_sst_size[%lu]", fd_idx_size, fd_sst_size);
-        size_t idx_cnt = fd_idx_size / sizeof(slice_idx_t);
-        slice_idx_t* idxes = new slice_idx_t[idx_cnt];
-        ssize_t ssret = pread(fd_idx, idxes, fd_idx_size, 0);
-        if (ssret != fd_idx_size) _error("read[%lu] fd_idx_size[%lu]", ssret, fd_idx_size);
+        _error("path[%s] idx_map[%p] sst_map[%p] err[%s]", sst_path, idx_map, sst_map, strerror(errno));
+        if (idx_map != MAP_FAILED) munmap(idx_map, fd_idx_size);
+        if (sst_map != MAP_FAILED) munmap(sst_map, fd_sst_size);
+    }
 
-        if (mode_ == PAPYRUSKV_SSTABLE_SEQ) ret = GetSequential(key, keylen, valp, vallenp, rank, idxes, idx_cnt, fd_sst, fd_sst_size);
-        else if (mode_ == PAPYRUSKV_SSTABLE_BIN) ret = GetBinary(key, keylen, valp, vallenp, rank, idxes, idx_cnt, fd_sst, fd_sst_size);
+    slice_idx_t* idxes = new slice_idx_t[idx_cnt];
+    ssize_t ssret = pread(fd_idx, idxes, fd_idx_size, 0);
+    if (ssret != fd_idx_size) _error("read[%lu] fd_idx_size[%lu]", ssret, fd_idx_size);
 
-        delete[] idxes;
+    int iret = close(fd_idx);
+    if (iret != 0) _error("fd[%d] ret[%d]", fd_idx, iret);
+
+    return new Table(rank, level, sid, fd_sst, fd_sst_size, idxes, idx_cnt, bits, bitslen);
+}
 
-        int iret = close(fd_idx);
-        if (iret != 0) _error("fd[%d] ret[%d]", fd_idx, iret);
-        iret = close(fd_sst);
-        if (iret != 0) _error("fd[%d] ret[%d]", fd_idx, iret);
+Table* SSTable::OpenTable(int rank, int level, uint64_t sid, int fd_sst, off_t fd_sst_size, table_footer_t* footer, uint64_t* bits, size_t bitslen) {
+    _trace("sid[%lu] fd_sst_size[%lu] index_off[%lu] index_size[%lu] count[%lu]", sid, fd_sst_size, footer->index_off, footer->index_size, footer->count);
+    if ((mode_ & PAPYRUSKV_SSTABLE_MMAP)) {
+        void* sst_map = mmap(NULL, fd_sst_size, PROT_READ, MAP_SHARED, fd_sst, 0);
+        if (sst_map != MAP_FAILED)
+            return new Table(rank, level, sid, fd_sst, fd_sst_size, (char*) sst_map, footer, (char*) sst_map + footer->index_off, bits, bitslen);
+        _error("sid[%lu] err[%s]", sid, strerror(errno));
     }
 
+    char* index = new char[footer->index_size];
+    ssize_t ssret = pread(fd_sst, index, footer->index_size, footer->index_off);
+    if (ssret != (ssize_t) footer->index_size) _error("read[%zd] index_size[%lu]", ssret, footer->index_size);
+
+    return new Table(rank, level, sid, fd_sst, fd_sst_size, NULL, footer, index, bits, bitslen);
+}
+
+int SSTable::GetBlock(const char* key, size_t keylen, char** valp, size_t* vallenp, Table* table, View* view) {
+    BlockIterator index(table->index(), table->index_size());
+    index.Seek(key, keylen);
+    if (!index.Valid()) return PAPYRUSKV_SLICE_NOT_FOUND;
+
+    block_handle_t handle;
+    memcpy(&handle, index.val(), sizeof(handle));
+    char* buf = table->mapped() ? NULL : new char[handle.size];
+    const char* data = table->Read(handle.off, handle.size, buf);
+
+    int ret = PAPYRUSKV_SLICE_NOT_FOUND;
+    BlockIterator block(data, handle.size);
+    block.Seek(key, keylen);
+    if (block.Valid() && Utils::Compare(block.key(), block.keylen(), key, keylen) == 0) {
+        if (block.tombstone()) ret = PAPYRUSKV_SLICE_TOMBSTONE;
+        else {
+            size_t vallen = block.vallen();
+            if (vallenp) *vallenp = vallen;
+            if (view && table->mapped()) view->Pin(table_cache_, table, block.val(), vallen);
+            else if (view) {
+                char* val = pool_->AllocVal(vallen);
+                memcpy(val, block.val(), vallen);
+                view->Own(val, vallen);
+            } else if (valp) {
+                if (*valp == NULL) *valp = pool_->AllocVal(vallen);
+                memcpy(*valp, block.val(), vallen);
+            }
+            ret = PAPYRUSKV_SLICE_FOUND;
+        }
+    }
+    if (buf) delete[] buf;
     return ret;
 }
 
-int SSTable::GetSequential(const char* key, size_t keylen, char** valp, size_t* vallenp, int rank, slice_idx_t* idxes, size_t idx_cnt, int fd_sst, off_t fd_sst_size) {
+int SSTable::GetSequential(const char* key, size_t keylen, char** valp, size_t* vallenp, Table* table, View* view) {
+    slice_idx_t* idxes = table->idxes();
+    size_t idx_cnt = table->idx_cnt();
     int ret = PAPYRUSKV_SLICE_NOT_FOUND;
-    char* k = new char[keylen];
+    char* buf = table->mapped() ? NULL : new char[keylen];
     for (size_t j = 0; j < idx_cnt; j++) {
         uint64_t idx = idxes[j].idx;
         uint64_t len = idxes[j].len;
@@ -158,38 +307,32 @@ int SSTable::GetSequential(const char* key, size_t keylen, char** valp, size_t*
         _trace("idx[%lu] len[%lu] tombstone[%d]", idx, len, tombstone);
         if (keylen != len) continue;
 
-        ssize_t ssret = pread(fd_sst, k, len, idx);
-        if (ssret != len) _error("ssret[%ld] len[%lu]", ssret, len);
+        const char* k = table->Read(idx, len, buf);
         _trace("key[%s]", key);
 
-        if (strncmp(k, key, keylen) == 0) {
+        int cmp = memcmp(k, key, keylen);
+        if (cmp == 0) {
             if (tombstone) {
                 ret = PAPYRUSKV_SLICE_TOMBSTONE;
                 break;
             }
-            size_t vallen = (j == idx_cnt - 1) ?
-                fd_sst_size - idx - len : idxes[j + 1].idx - idx - len;
-            if (vallenp) *vallenp = vallen;
-            if (valp) {
-                if (*valp == NULL) *valp = pool_->AllocVal(vallen);
-                ssize_t ssret = pread(fd_sst, *valp, vallen, idx + len); 
-                if (ssret != vallen) _error("ssret[%ld] vallen[%lu]", ssret, vallen);
-                _trace("val[%s] vallen[%lu]", *valp, vallen);
-            }
+            CopyValue(table, j, valp, vallenp, view);
             ret = PAPYRUSKV_SLICE_FOUND;
             break;
-        } else if (strncmp(k, key, keylen) > 0) {
+        } else if (cmp > 0) {
             ret = PAPYRUSKV_SLICE_NOT_FOUND;
             break;
         }
     }
-    delete[] k;
+    if (buf) delete[] buf;
     return ret;
 }
 
-int SSTable::GetBinary(const char* key, size_t keylen, char** valp, size_t* vallenp, int rank, slice_idx_t* idxes, size_t idx_cnt, int fd_sst, off_t fd_sst_size) {
+int SSTable::GetBinary(const char* key, size_t keylen, char** valp, size_t* vallenp, Table* table, View* view) {
+    slice_idx_t* idxes = table->idxes();
+    size_t idx_cnt = table->idx_cnt();
     int ret = PAPYRUSKV_SLICE_NOT_FOUND;
-    char* k = new char[keylen];
+    char* buf = table->mapped() ? NULL : new char[PAPYRUSKV_MAX_KEYLEN];
     size_t idx_min = 0;
     size_t idx_max = idx_cnt - 1;
     do {
@@ -200,54 +343,325 @@ int SSTable::GetBinary(const char* key, size_t keylen, char** valp, size_t* vall
         uint8_t tombstone = idxes[j].tombstone;
         _trace("idx_min[%lu] idx_max[%lu] j[%lu] idx[%lu] len[%lu] tombstone[%d]", idx_min, idx_max, j, idx, len, tombstone);
 
-        ssize_t ssret = pread(fd_sst, k, len, idx);
-        if (ssret != len) _error("ssret[%ld] len[%lu]", ssret, len);
+        const char* k = table->Read(idx, len, buf);
         _trace("key[%s]", key);
 
         uint64_t min_len = keylen < len ? keylen : len;
+        int cmp = memcmp(k, key, min_len);
 
-        if (strncmp(k, key, min_len) == 0) {
+        if (cmp == 0) {
             if (keylen == len) {
                 if (tombstone) {
                     ret = PAPYRUSKV_SLICE_TOMBSTONE;
                     break;
                 }
-                size_t vallen = (j == idx_cnt - 1) ?
-                    fd_sst_size - idx - len : idxes[j + 1].idx - idx - len;
-                if (vallenp) *vallenp = vallen;
-                if (valp) {
-                    if (*valp == NULL) *valp = pool_->AllocVal(vallen);
-                    ssize_t ssret = pread(fd_sst, *valp, vallen, idx + len); 
-                    if (ssret != vallen) _error("ssret[%ld] vallen[%lu]", ssret, vallen);
-                    _trace("val[%s] vallen[%lu]", *valp, vallen);
-                }
+                CopyValue(table, j, valp, vallenp, view);
                 ret = PAPYRUSKV_SLICE_FOUND;
                 break;
             } else if (keylen < len) {
+                if (j == 0) break;
                 idx_max = j - 1;
                 continue;
             } else if (keylen > len) {
                 idx_min = j + 1;
                 continue;
             }
-        } else if (strncmp(k, key, min_len) < 0) {
+        } else if (cmp < 0) {
             if (j == idx_cnt - 1) break;
             idx_min = j + 1;
             continue;
-        } else if (strncmp(k, key, min_len) > 0) {
+        } else if (cmp > 0) {
             if (j == 0) break;
             idx_max = j - 1;
             continue;
         }
     } while (idx_min <= idx_max);
-    delete[] k;
+    if (buf) delete[] buf;
+    return ret;
+}
+
+void SSTable::CopyValue(Table* table, size_t j, char** valp, size_t* vallenp, View* view) {
+    size_t vallen = table->ValLen(j);
+    if (vallenp) *vallenp = vallen;
+    uint64_t off = table->idxes()[j].idx + table->idxes()[j].len;
+    if (view && table->mapped()) {
+        view->Pin(table_cache_, table, table->Read(off, vallen, NULL), vallen);
+        return;
+    }
+    if (view) {
+        char* val = pool_->AllocVal(vallen);
+        table->Read(off, vallen, val);
+        view->Own(val, vallen);
+        return;
+    }
+    if (!valp) return;
+    if (*valp == NULL) *valp = pool_->AllocVal(vallen);
+    if (table->mapped()) memcpy(*valp, table->Read(off, vallen, NULL), vallen);
+    else table->Read(off, vallen, *valp);
+    _trace("val[%s] vallen[%lu]", *valp, vallen);
+}
+
+bool SSTable::Compact() {
+    std::vector<table_meta_t> inputs;
+    bool bottom = false;
+
+    pthread_rwlock_rdlock(&rwlock_tables_);
+    int level = PickCompaction(&inputs, &bottom);
+    pthread_rwlock_unlock(&rwlock_tables_);
+    if (level == -1) return false;
+
+    table_meta_t output = {};
+    output.level = level;
+    if (!Merge(inputs, bottom, &output)) return false;
+    return Install(inputs, output);
+}
+
+int SSTable::PickCompaction(std::vector<table_meta_t>* inputs, bool* bottom) {
+    if (!enable_compaction_ || pins_ > 0) return -1;
+
+    size_t l0 = 0;
+    for (auto it = tables_.begin(); it != tables_.end(); ++it)
+        if (it->level == 0) l0++;
+
+    int level = -1;
+    if (l0 >= compaction_trigger_) {
+        for (auto it = tables_.begin(); it != tables_.end(); ++it)
+            if (it->level <= 1) inputs->push_back(*it);
+        level = 1;
+    } else {
+        for (auto it = tables_.begin(); it != tables_.end(); ++it) {
+            if (it->level == 0 || it->level >= PAPYRUSKV_MAX_LEVEL) continue;
+            if (it->size <= LevelLimit(it->level)) continue;
+            inputs->push_back(*it);
+            if (it + 1 != tables_.end() && (it + 1)->level == it->level + 1)
+                inputs->push_back(*(it + 1));
+            level = it->level + 1;
+            break;
+        }
+    }
+    if (level == -1) return -1;
+
+    *bottom = tables_.back().level <= level;
+    return level;
+}
+
+bool SSTable::Merge(std::vector<table_meta_t>& inputs, bool bottom, table_meta_t* output) {
+    std::vector<Table*> tables;
+    std::vector<TableIterator*> iters;
+    for (auto it = inputs.begin(); it != inputs.end(); ++it) {
+        if (it->sid > output->sid) output->sid = it->sid;
+        Table* table = OpenTable(rank_, it->level, it->sid);
+        if (table == NULL) break;
+        tables.push_back(table);
+        iters.push_back(new TableIterator(table));
+    }
+
+    bool ret = tables.size() == inputs.size();
+    if (ret) {
+        char idx_path[256];
+        char sst_path[256];
+        char blm_path[256];
+        GetIDXPath(output->level, rank_, output->sid, root_, idx_path);
+        GetSSTPath(output->level, rank_, output->sid, root_, sst_path);
+        GetBLMPath(output->level, rank_, output->sid, root_, blm_path);
+
+        uint64_t expected = 0UL;
+        for (auto it = inputs.begin(); it != inputs.end(); ++it) expected += it->count;
+        TableBuilder builder(idx_path, sst_path, enable_bloom_ ? blm_path : NULL, bloom_, expected, block_size_, direct_io_);
+        while (true) {
+            /* inputs are ordered newest first, so ties go to the lower index */
+            TableIterator* min = NULL;
+            for (auto it = iters.begin(); it != iters.end(); ++it) {
+                if (!(*it)->Valid()) continue;
+                if (min == NULL || Utils::Compare((*it)->key(), (*it)->keylen(), min->key(), min->keylen()) < 0) min = *it;
+            }
+            if (min == NULL) break;
+
+            for (auto it = iters.begin(); it != iters.end(); ++it) {
+                if (*it == min || !(*it)->Valid()) continue;
+                if (Utils::Compare((*it)->key(), (*it)->keylen(), min->key(), min->keylen()) == 0) (*it)->Next();
+            }
+
+            if (!bottom || !min->tombstone())
+                builder.Add(min->key(), min->keylen(), min->val(), min->vallen(), min->tombstone());
+            min->Next();
+        }
+        ret = builder.Finish();
+        output->count = builder.count();
+        output->size = builder.size();
+        output->min = builder.min_key();
+        output->max = builder.max_key();
+        if (!ret) _error("level[%d] sid[%lu] path[%s]", output->level, output->sid, sst_path);
+    }
+
+    for (auto it = iters.begin(); it != iters.end(); ++it) delete *it;
+    for (auto it = tables.begin(); it != tables.end(); ++it) delete *it;
+    if (!ret) Retire(*output);
     return ret;
 }
 
-bool SSTable::SendFile(uint64_t sid, const char* suffix, const char* dst) {
+bool SSTable::Install(std::vector<table_meta_t>& inputs, table_meta_t& output) {
+    char path[256];
+    GetMFTPath(rank_, root_, path);
+
+    pthread_rwlock_wrlock(&rwlock_tables_);
+    if (pins_ > 0) {
+        pthread_rwlock_unlock(&rwlock_tables_);
+        Retire(output);
+        return false;
+    }
+    for (auto in = inputs.begin(); in != inputs.end(); ++in) {
+        for (auto it = tables_.begin(); it != tables_.end(); ++it) {
+            if (it->level != in->level || it->sid != in->sid) continue;
+            tables_.erase(it);
+            break;
+        }
+    }
+    if (output.count > 0) {
+        auto it = tables_.begin();
+        while (it != tables_.end() && it->level <= output.level) ++it;
+        tables_.insert(it, output);
+    }
+    PublishManifest(path);
+    pthread_rwlock_unlock(&rwlock_tables_);
+
+    _trace("level[%d] sid[%lu] count[%lu] size[%lu] inputs[%lu]", output.level, output.sid, output.count, output.size, inputs.size());
+
+    if (output.count == 0) Retire(output);
+    for (auto in = inputs.begin(); in != inputs.end(); ++in) {
+        table_cache_->Evict(rank_, in->level, in->sid);
+        Retire(*in);
+    }
+    return true;
+}
+
+void SSTable::Retire(const table_meta_t& meta) {
+    char path[256];
+    GetIDXPath(meta.level, rank_, meta.sid, root_, path);
+    unlink(path);
+    GetSSTPath(meta.level, rank_, meta.sid, root_, path);
+    unlink(path);
+    GetBLMPath(meta.level, rank_, meta.sid, root_, path);
+    unlink(path);
+}
+
+uint64_t SSTable::LevelLimit(int level) {
+    uint64_t limit = compaction_base_;
+    for (int i = 1; i < level; i++) limit *= PAPYRUSKV_COMPACTION_RATIO;
+    return limit;
+}
+
+void SSTable::Pin() {
+    pthread_rwlock_wrlock(&rwlock_tables_);
+    pins_++;
+    pthread_rwlock_unlock(&rwlock_tables_);
+}
+
+void SSTable::Unpin() {
+    pthread_rwlock_wrlock(&rwlock_tables_);
+    pins_--;
+    pthread_rwlock_unlock(&rwlock_tables_);
+}
+
+uint64_t SSTable::Next(uint64_t sid) {
+    uint64_t next = 0UL;
+    pthread_rwlock_rdlock(&rwlock_tables_);
+    for (auto it = tables_.begin(); it != tables_.end(); ++it) {
+        if (it->sid >= sid) continue;
+        next = it->sid;
+        break;
+    }
+    pthread_rwlock_unlock(&rwlock_tables_);
+    return next;
+}
+
+/* Writes tables_ out and only then bumps the version peers are told, so a
+ * peer never caches an older manifest under a newer version. Called with
+ * rwlock_tables_ held for writing. */
+void SSTable::PublishManifest(const char* path) {
+    if (WriteManifest(tables_, path)) __atomic_store_n(&version_, version_ + 1, __ATOMIC_RELEASE);
+}
+
+bool SSTable::WriteManifest(std::vector<table_meta_t>& tables, const char* path) {
+    std::string buf;
+    uint32_t header[2] = { PAPYRUSKV_MANIFEST_MAGIC, PAPYRUSKV_MANIFEST_VERSION };
+    uint64_t count = tables.size();
+    buf.append((const char*) header, sizeof(header));
+    buf.append((const char*) &count, sizeof(count));
+    for (auto it = tables.begin(); it != tables.end(); ++it) {
+        manifest_entry_t entry = { it->level, (uint32_t) it->min.size(), it->sid, it->count, it->size, (uint64_t) it->max.size() };
+        buf.append((const char*) &entry, sizeof(entry));
+        buf.append(it->min);
+        buf.append(it->max);
+    }
+
+    char tmp[256];
+    sprintf(tmp, "%s.tmp", path);
+    int fd = open(tmp, O_CREAT | O_WRONLY | O_TRUNC, S_IRUSR | S_IWUSR);
+    if (fd == -1) {
+        _error("path[%s]", tmp);
+        return false;
+    }
+    bool ret = write(fd, buf.data(), buf.size()) == (ssize_t) buf.size();
+    if (!ret) _error("path[%s] count[%lu]", tmp, count);
+
+    int iret = close(fd);
+    if (iret == -1) _error("path[%s]", tmp);
+    if (ret && rename(tmp, path) == -1) {
+        _error("path[%s] err[%s]", path, strerror(errno));
+        ret = false;
+    }
+    return ret;
+}
+
+bool SSTable::ReadManifest(std::vector<table_meta_t>* tables, const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) return false;
+    off_t size = lseek(fd, 0, SEEK_END);
+    char* buf = new char[size];
+    bool ret = pread(fd, buf, size, 0) == size;
+    close(fd);
+
+    const char* p = buf;
+    const char* end = buf + size;
+    uint32_t header[2];
+    uint64_t count = 0;
+    ret = ret && p + sizeof(header) + sizeof(count) <= end;
+    if (ret) {
+        memcpy(header, p, sizeof(header));
+        memcpy(&count, p + sizeof(header), sizeof(count));
+        p += sizeof(header) + sizeof(count);
+        ret = header[0] == PAPYRUSKV_MANIFEST_MAGIC && header[1] <= PAPYRUSKV_MANIFEST_VERSION;
+    }
+    for (uint64_t i = 0; ret && i < count; i++) {
+        manifest_entry_t entry;
+        /* version 1 entries carry no key fences */
+        size_t entry_size = header[1] == 1 ? sizeof(entry) - sizeof(entry.maxlen) : sizeof(entry);
+        ret = p + entry_size <= end;
+        if (!ret) break;
+        memset(&entry, 0, sizeof(entry));
+        memcpy(&entry, p, entry_size);
+        if (header[1] == 1) entry.minlen = 0;
+        p += entry_size;
+        ret = p + entry.minlen + entry.maxlen <= end;
+        if (!ret) break;
+        table_meta_t meta = { entry.level, entry.sid, entry.count, entry.size, std::string(p, entry.minlen), std::string(p + entry.minlen, entry.maxlen) };
+        p += entry.minlen + entry.maxlen;
+        tables->push_back(meta);
+    }
+    if (!ret) {
+        _error("path[%s] count[%lu]", path, count);
+        tables->clear();
+    }
+
+    delete[] buf;
+    return ret;
+}
+
+bool SSTable::SendFile(int level, uint64_t sid, const char* suffix, const char* dst) {
     bool ret = true;
     char path[256];
-    GetPath(0, rank_, sid, root_, suffix, path);
+    GetPath(level, rank_, sid, root_, suffix, path);
     int fd_src = open(path, O_RDONLY);
     if (fd_src == -1) {
         _error("path[%s]", path);
@@ -258,10 +672,11 @@ bool SSTable::SendFile(uint64_t sid, const char* suffix, const char* dst) {
     off_t oret = lseek(fd_src, 0, SEEK_SET);
     if (oret != 0) _error("oret[%ld]", oret);
 
-    GetPathNoRank(0, rank_, sid, (char*) dst, suffix, path);
-    int fd_dst = open(path, O_CREAT | O_WRONLY, S_IRUSR | S_IWUSR);
+    GetPathNoRank(level, rank_, sid, (char*) dst, suffix, path);
+    int fd_dst = open(path, O_CREAT | O_WRONLY | O_TRUNC, S_IRUSR | S_IWUSR);
     if (fd_dst == -1) {
         _error("path[%s]", path);
+        close(fd_src);
         return false;
     }
 
@@ -280,22 +695,34 @@ bool SSTable::SendFile(uint64_t sid, const char* suffix, const char* dst) {
 }
 
 uint64_t SSTable::SendFiles(uint64_t sid, const char* dst) {
-    pthread_mutex_lock(&mutex_);
     Utils::Mkdir(dst);
-    //TODO: outer-loop for levels
-    for (uint64_t i = sid; i > 0; i--) {
-        SendFile(i, "idx", dst);
-        SendFile(i, "sst", dst);
-        if (enable_bloom_) SendFile(i, "blm", dst);
+
+    std::vector<table_meta_t> tables;
+    pthread_rwlock_rdlock(&rwlock_tables_);
+    for (auto it = tables_.begin(); it != tables_.end(); ++it)
+        if (it->sid <= sid) tables.push_back(*it);
+    pthread_rwlock_unlock(&rwlock_tables_);
+
+    for (auto it = tables.begin(); it != tables.end(); ++it) {
+        char path[256];
+        GetIDXPath(it->level, rank_, it->sid, root_, path);
+        SendFile(it->level, it->sid, "sst", dst);
+        if (access(path, F_OK) == 0) SendFile(it->level, it->sid, "idx", dst);
+        if (enable_bloom_) SendFile(it->level, it->sid, "blm", dst);
     }
-    pthread_mutex_unlock(&mutex_);
+
+    char path[256];
+    GetMFTPathNoRank(rank_, (char*) dst, path);
+    WriteManifest(tables, path);
+
+    Unpin();
     return sid;
 }
 
-bool SSTable::RecvFile(uint64_t sid, const char* suffix, const char* src) {
+bool SSTable::RecvFile(int level, uint64_t sid, const char* suffix, const char* src) {
     bool ret = true;
     char path[256];
-    GetPathNoRank(0, rank_, sid, (char*) src, suffix, path);
+    GetPathNoRank(level, rank_, sid, (char*) src, suffix, path);
     int fd_src = open(path, O_RDONLY);
     if (fd_src == -1) {
         _error("path[%s]", path);
@@ -306,15 +733,19 @@ bool SSTable::RecvFile(uint64_t sid, const char* suffix, const char* src) {
     off_t oret = lseek(fd_src, 0, SEEK_SET);
     if (oret != 0) _error("oret[%ld]", oret);
 
-    GetPath(0, rank_, sid, root_, suffix, path);
-    int fd_dst = open(path, O_CREAT | O_WRONLY, S_IRUSR | S_IWUSR);
+    GetPath(level, rank_, sid, root_, suffix, path);
+    int fd_dst = open(path, O_CREAT | O_WRONLY | O_TRUNC, S_IRUSR | S_IWUSR);
     if (fd_dst == -1) {
         _error("path[%s]", path);
+        close(fd_src);
         return false;
     }
 
     ssize_t ssret = sendfile(fd_dst, fd_src, NULL, (size_t) fd_size);
-    if (ssret != fd_size) _error("ssret[%zd] fd_size[%ld]", ssret, fd_size);
+    if (ssret != fd_size) {
+        _error("ssret[%zd] fd_size[%ld]", ssret, fd_size);
+        ret = false;
+    }
 
     int iret = close(fd_src);
     if (iret == -1) _error("path[%s]", path);
@@ -326,84 +757,76 @@ bool SSTable::RecvFile(uint64_t sid, const char* suffix, const char* src) {
 
 uint64_t SSTable::RecvFiles(uint64_t sid, const char* src) {
     pthread_mutex_lock(&mutex_);
-    //TODO: outer-loop for levels
-    for (uint64_t i = sid; i > 0; i--) {
-        RecvFile(i, "idx", src);
-        RecvFile(i, "sst", src);
-        if (enable_bloom_) RecvFile(i, "blm", src);
+    char path[256];
+    GetMFTPathNoRank(rank_, (char*) src, path);
+    std::vector<table_meta_t> tables;
+    if (!ReadManifest(&tables, path)) {
+        for (uint64_t i = sid; i > 0; i--) {
+            table_meta_t meta = {};
+            meta.sid = i;
+            tables.push_back(meta);
+        }
+    }
+
+    std::vector<table_meta_t> received;
+    for (auto it = tables.begin(); it != tables.end(); ++it) {
+        GetPathNoRank(it->level, rank_, it->sid, (char*) src, "idx", path);
+        if (!RecvFile(it->level, it->sid, "sst", src)) continue;
+        if (access(path, F_OK) == 0 && !RecvFile(it->level, it->sid, "idx", src)) continue;
+        if (enable_bloom_) RecvFile(it->level, it->sid, "blm", src);
+        received.push_back(*it);
     }
+
+    GetMFTPath(rank_, root_, path);
+    pthread_rwlock_wrlock(&rwlock_tables_);
+    tables_ = received;
     sid_ = sid;
+    PublishManifest(path);
+    pthread_rwlock_unlock(&rwlock_tables_);
     pthread_mutex_unlock(&mutex_);
     return sid_;
 }
 
 uint64_t SSTable::DistributeFiles(uint64_t* sids, int size, const char* root) {
-//    pthread_mutex_lock(&mutex_);
     uint64_t sid = 0UL;
     uint64_t seq = 0UL;
 
-    char* key = new char[PAPYRUSKV_MAX_KEYLEN];
-    char* val = new char[PAPYRUSKV_MAX_VALLEN];
-
     for (int rank = 0; rank < size; rank++) {
-        for (uint64_t i = sids[rank]; i > 0; i--) {
+        char path[256];
+        GetMFTPathNoRank(rank, (char*) root, path);
+        std::vector<table_meta_t> tables;
+        if (!ReadManifest(&tables, path)) {
+            for (uint64_t i = sids[rank]; i > 0; i--) {
+                table_meta_t meta = {};
+                meta.sid = i;
+                tables.push_back(meta);
+            }
+        }
+
+        for (auto it = tables.begin(); it != tables.end(); ++it) {
             if (seq++ % nranks_ != rank_) continue;
             sid++;
-            _trace("distribute rank[%d] sid[%lu] seq[%d] sid[%lu]", rank, i, seq, sid);
-
-            char path[256];
-            GetIDXPath(0, rank, i, (char*) root, path);
-            int fd_idx = open(path, O_RDONLY);
-            if (fd_idx == -1) {
-                _error("fd[%d] path[%s]", fd_idx, path);
-                break;
-            }
-            GetSSTPath(0, rank, i, (char*) root, path);
-            int fd_sst = open(path, O_RDONLY);
-            if (fd_sst == -1) {
-                _error("fd[%d] path[%s]", fd_sst, path);
+            _trace("distribute rank[%d] level[%d] sid[%lu] seq[%d] sid[%lu]", rank, it->level, it->sid, seq, sid);
+
+            char idx_path[256];
+            char sst_path[256];
+            GetPathNoRank(it->level, rank, it->sid, (char*) root, "idx", idx_path);
+            GetPathNoRank(it->level, rank, it->sid, (char*) root, "sst", sst_path);
+            Table* table = OpenTable(rank, it->level, it->sid, idx_path, sst_path, NULL);
+            if (table == NULL) {
+                _error("path[%s]", sst_path);
                 break;
             }
-            off_t fd_idx_size = lseek(fd_idx, 0, SEEK_END);
-            off_t fd_sst_size = lseek(fd_sst, 0, SEEK_END);
-            _trace("fd_idx_size[%lu] fd_sst_size[%lu]", fd_idx_size, fd_sst_size);
-            size_t idx_cnt = fd_idx_size / sizeof(slice_idx_t);
-            slice_idx_t* idxes = new slice_idx_t[idx_cnt];
-            ssize_t ssret = pread(fd_idx, idxes, fd_idx_size, 0);
-            if (ssret != fd_idx_size) _error("read[%zd] fd_idx_size[%lu]", ssret, fd_idx_size);
-
-            for (size_t j = 0; j < idx_cnt; j++) {
-                uint64_t idx = idxes[j].idx;
-                uint64_t len = idxes[j].len;
-                uint8_t tombstone = idxes[j].tombstone;
-                _trace("idx[%lu] len[%lu] tombstone[%d]", idx, len, tombstone);
-
-                ssize_t ssret = pread(fd_sst, key, len, idx);
-                if (ssret != len) _error("ret[%zd] keylen[%lu]", ssret, len);
-                _trace("key[%s] keylen[%lu]", key, len);
-
-                size_t vallen = (j == idx_cnt - 1) ?
-                    fd_sst_size - idx - len : idxes[j + 1].idx - idx - len;
-                ssret = pread(fd_sst, val, vallen, idx + len); 
-                if (ssret != vallen) _error("ret[%zd] vallen[%lu]", ssret, vallen);
-                _trace("key[%s] keylen[%lu] val[%s] vallen[%lu]", key, len, val, vallen);
-
-                int ret = db_->Put((const char*) key, len, (const char*) val, vallen);
-                _trace("ret[%d] key[%s] keylen[%lu] val[%s] vallen[%lu]", ret, key, len, val, vallen);
-                if (ret != PAPYRUSKV_OK) _error("ret[%d] key[%s] keylen[%lu] val[%s] vallen[%lu]", ret, key, len, val, vallen);
-            }
-            delete[] idxes;
 
-            int iret = close(fd_idx);
-            if (iret != 0) _error("fd[%d] ret[%d]", fd_idx, iret);
-            iret = close(fd_sst);
-            if (iret != 0) _error("fd[%d] ret[%d]", fd_idx, iret);
+            for (TableIterator iter(table); iter.Valid(); iter.Next()) {
+                int ret = db_->Put(iter.key(), iter.keylen(), iter.val(), iter.vallen());
+                _trace("ret[%d] key[%s] keylen[%lu] val[%s] vallen[%lu]", ret, iter.key(), iter.keylen(), iter.val(), iter.vallen());
+                if (ret != PAPYRUSKV_OK) _error("ret[%d] key[%s] keylen[%lu] vallen[%lu]", ret, iter.key(), iter.keylen(), iter.vallen());
+            }
+            delete table;
         }
     }
-    delete[] key;
-    delete[] val;
     delete[] sids;
-//    pthread_mutex_unlock(&mutex_);
     return sid;
 }
 
@@ -449,57 +872,25 @@ int SSTable::ReadTOC(uint64_t** sids, int* size, const char* root) {
 }
 
 int SSTable::Load(MemTable* mt, uint64_t sid) {
-    char* key = new char[PAPYRUSKV_MAX_KEYLEN];
-    char* val = new char[PAPYRUSKV_MAX_VALLEN];
-
-    char path[256];
-    GetIDXPath(0, rank_, sid, root_, path);
-    int fd_idx = open(path, O_RDONLY);
-    if (fd_idx == -1) {
-        _error("fd[%d] path[%s]", fd_idx, path);
-        return PAPYRUSKV_ERR;
-    }
-    GetSSTPath(0, rank_, sid, root_, path);
-    int fd_sst = open(path, O_RDONLY);
-    if (fd_sst == -1) {
-        _error("fd[%d] path[%s]", fd_sst, path);
-        return PAPYRUSKV_ERR;
+    int level = 0;
+    pthread_rwlock_rdlock(&rwlock_tables_);
+    for (auto it = tables_.begin(); it != tables_.end(); ++it) {
+        if (it->sid != sid) continue;
+        level = it->level;
+        break;
     }
-    off_t fd_idx_size = lseek(fd_idx, 0, SEEK_END);
-    off_t fd_sst_size = lseek(fd_sst, 0, SEEK_END);
-    _trace("fd_idx_size[%lu] fd_sst_size[%lu]", fd_idx_size, fd_sst_size);
-    size_t idx_cnt = fd_idx_size / sizeof(slice_idx_t);
-    slice_idx_t* idxes = new slice_idx_t[idx_cnt];
-    ssize_t ssret = pread(fd_idx, idxes, fd_idx_size, 0);
-    if (ssret != fd_idx_size) _error("read[%zd] fd_idx_size[%lu]", ssret, fd_idx_size);
+    pthread_rwlock_unlock(&rwlock_tables_);
 
-    for (size_t j = 0; j < idx_cnt; j++) {
-        uint64_t idx = idxes[j].idx;
-        uint64_t len = idxes[j].len;
-        uint8_t tombstone = idxes[j].tombstone;
-        _trace("idx[%lu] len[%lu] tombstone[%d]", idx, len, tombstone);
-
-        ssize_t ssret = pread(fd_sst, key, len, idx);
-        if (ssret != len) _error("ret[%zd] keylen[%lu]", ssret, len);
-        _trace("key[%s] keylen[%lu]", key, len);
+    Table* table = OpenTable(rank_, level, sid);
+    if (table == NULL) return PAPYRUSKV_ERR;
 
-        size_t vallen = (j == idx_cnt - 1) ?
-            fd_sst_size - idx - len : idxes[j + 1].idx - idx - len;
-        ssret = pread(fd_sst, val, vallen, idx + len); 
-        if (ssret != vallen) _error("ret[%zd] vallen[%lu]", ssret, vallen);
-        _trace("key[%s] keylen[%lu] val[%s] vallen[%lu]", key, len, val, vallen);
-
-        Slice* slice = new Slice(key, len, val, vallen, rank_, tombstone == 1);
-        mt->Put(slice);
+    for (TableIterator iter(table); iter.Valid(); iter.Next()) {
+        _trace("key[%s] keylen[%lu] val[%s] vallen[%lu]", iter.key(), iter.keylen(), iter.val(), iter.vallen());
+        mt->Put(iter.key(), iter.keylen(), iter.val(), iter.vallen(), rank_, iter.tombstone());
     }
-    delete[] key;
-    delete[] val;
-    delete[] idxes;
-
-    int iret = close(fd_idx);
-    if (iret != 0) _error("fd[%d] ret[%d]", fd_idx, iret);
-    iret = close(fd_sst);
-    if (iret != 0) _error("fd[%d] ret[%d]", fd_idx, iret);
+    mt->SortByKey();
+    mt->set_mid(sid);
+    delete table;
 
     return PAPYRUSKV_OK;
 }
@@ -524,6 +915,14 @@ void SSTable::GetBLMPath(int level, int rank, uint64_t sid, char* root, char* pa
     GetPath(level, rank, sid, root, "blm", path);
 }
 
+void SSTable::GetMFTPath(int rank, char* root, char* path) {
+    sprintf(path, "%s/%d/%s_%d.mft", root, rank, db_->name(), rank);
+}
+
+void SSTable::GetMFTPathNoRank(int rank, char* root, char* path) {
+    sprintf(path, "%s/%s_%d.mft", root, db_->name(), rank);
+}
+
 void SSTable::GetTOCPath(const char* root, char* path) {
     sprintf(path, "%s/%s.toc", root, db_->name());
 }
@@ -4,18 +4,36 @@
 #include "Bloom.h"
 #include "MemTable.h"
 #include "Pool.h"
+#include "Table.h"
+#include "TableCache.h"
+#include "View.h"
 #include <stdint.h>
 #include <pthread.h>
+#include <vector>
 
-namespace papyruskv {
+#define PAPYRUSKV_MANIFEST_MAGIC            0x4d564b50
+#define PAPYRUSKV_MANIFEST_VERSION          2
 
-class DB;
+namespace papyruskv {
 
+/* On-disk manifest entry, followed by the min and max keys. */
 typedef struct {
-    uint64_t idx;
-    uint64_t len;
-    uint8_t tombstone;
-} slice_idx_t;
+    int32_t level;
+    uint32_t minlen;
+    uint64_t sid;
+    uint64_t count;
+    uint64_t size;
+    uint64_t maxlen;
+} manifest_entry_t;
+
+/* A group peer's manifest as of the manifest version its owner last reported;
+ * version 0 means nothing is cached. */
+typedef struct {
+    uint64_t version;
+    std::vector<table_meta_t> tables;
+} peer_manifest_t;
+
+class DB;
 
 class SSTable {
 public:
@@ -23,29 +41,56 @@ public:
     ~SSTable();
 
     uint64_t sid() const { return sid_; }
+    uint64_t version() const { return __atomic_load_n(&version_, __ATOMIC_ACQUIRE); }
     uint64_t Flush(MemTable* mt);
 
     int Get(const char* key, size_t keylen, char** valp, size_t* vallenp);
-    int Get(const char* key, size_t keylen, char** valp, size_t* vallenp, int rank, int sid);
+    int Get(const char* key, size_t keylen, char** valp, size_t* vallenp, int rank, int sid, uint64_t version);
+    int GetView(const char* key, size_t keylen, View* view);
     uint64_t SendFiles(uint64_t sid, const char* dst);
     uint64_t RecvFiles(uint64_t sid, const char* src);
     uint64_t DistributeFiles(uint64_t* sids, int size, const char* root);
     int WriteTOC(uint64_t* sids, int size, const char* root);
     int ReadTOC(uint64_t** sids, int* size, const char* root);
     int Load(MemTable* mt, uint64_t sid);
+    uint64_t Next(uint64_t sid);
+    Table* OpenTable(int rank, int level, uint64_t sid);
+
+    bool Compact();
+    void Pin();
+    void Unpin();
 
 private:
-    int GetSequential(const char* key, size_t keylen, char** valp, size_t* vallenp, int rank, slice_idx_t* idxes, size_t idx_cnt, int fd_sst, off_t fd_sst_size);
-    int GetBinary(const char* key, size_t keylen, char** valp, size_t* vallenp, int rank, slice_idx_t* idxes, size_t idx_cnt, int fd_sst, off_t fd_sst_size);
+    int Search(const char* key, size_t keylen, char** valp, size_t* vallenp, int rank, std::vector<table_meta_t>& tables, View* view = NULL);
+    int GetSequential(const char* key, size_t keylen, char** valp, size_t* vallenp, Table* table, View* view);
+    int GetBinary(const char* key, size_t keylen, char** valp, size_t* vallenp, Table* table, View* view);
+    int GetBlock(const char* key, size_t keylen, char** valp, size_t* vallenp, Table* table, View* view);
+    void CopyValue(Table* table, size_t j, char** valp, size_t* vallenp, View* view);
+    Table* OpenTable(int rank, int level, uint64_t sid, const char* idx_path, const char* sst_path, const char* blm_path);
+    Table* OpenTable(int rank, int level, uint64_t sid, int fd_sst, off_t fd_sst_size, table_footer_t* footer, uint64_t* bits, size_t bitslen);
+
+    int PickCompaction(std::vector<table_meta_t>* inputs, bool* bottom);
+    bool Merge(std::vector<table_meta_t>& inputs, bool bottom, table_meta_t* output);
+    bool Install(std::vector<table_meta_t>& inputs, table_meta_t& output);
+    void Retire(const table_meta_t& meta);
+    uint64_t LevelLimit(int level);
+
+    void UpdatePeer(int rank, uint64_t version, std::vector<table_meta_t>& tables);
 
-    bool SendFile(uint64_t sid, const char* suffix, const char* dst);
-    bool RecvFile(uint64_t sid, const char* suffix, const char* src);
+    void PublishManifest(const char* path);
+    bool WriteManifest(std::vector<table_meta_t>& tables, const char* path);
+    bool ReadManifest(std::vector<table_meta_t>* tables, const char* path);
+
+    bool SendFile(int level, uint64_t sid, const char* suffix, const char* dst);
+    bool RecvFile(int level, uint64_t sid, const char* suffix, const char* src);
 
     void GetPath(int level, int rank, uint64_t sid, char* root, const char* suffix, char* path);
     void GetPathNoRank(int level, int rank, uint64_t sid, char* root, const char* suffix, char* path);
     void GetSSTPath(int level, int rank, uint64_t sid, char* root, char* path);
     void GetIDXPath(int level, int rank, uint64_t sid, char* root, char* path);
     void GetBLMPath(int level, int rank, uint64_t sid, char* root, char* path);
+    void GetMFTPath(int rank, char* root, char* path);
+    void GetMFTPathNoRank(int rank, char* root, char* path);
     void GetTOCPath(const char* root, char* path);
 
 private:
@@ -55,14 +100,28 @@ private:
     int group_;
     char root_[256];
     uint64_t sid_;
+    uint64_t version_;
     int mode_;
+    size_t block_size_;
 
     Pool* pool_;
     Bloom* bloom_;
+    TableCache* table_cache_;
 
     bool enable_bloom_;
+    bool enable_compaction_;
+    bool direct_io_;
+    size_t compaction_trigger_;
+    uint64_t compaction_base_;
+
+    std::vector<table_meta_t> tables_;
+    int pins_;
+
+    std::vector<peer_manifest_t> peers_;
 
     pthread_mutex_t mutex_;
+    pthread_rwlock_t rwlock_tables_;
+    pthread_rwlock_t rwlock_peers_;
 };
 
 } /* namespace papyruskv */
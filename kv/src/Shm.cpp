@@ -0,0 +1,72 @@
+#include "Shm.h"
+#include "Debug.h"
+#include "Platform.h"
+
+namespace papyruskv {
+
+Shm::Shm(Platform* platform) {
+    MPI_Comm comm = platform->mpi_comm();
+    int nranks = platform->size();
+    size_ = platform->shm_size();
+    off_ = 0UL;
+    inflight_ = 0;
+    pthread_mutex_init(&mutex_, NULL);
+
+    MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, platform->rank(), MPI_INFO_NULL, &node_comm_);
+    MPI_Win_allocate_shared((MPI_Aint) size_, 1, MPI_INFO_NULL, node_comm_, &base_, &win_);
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, win_);
+
+    int nlocals;
+    MPI_Comm_size(node_comm_, &nlocals);
+    std::vector<int> locals(nlocals);
+    std::vector<int> ranks(nlocals);
+    for (int i = 0; i < nlocals; i++) locals[i] = i;
+    MPI_Group group, node_group;
+    MPI_Comm_group(comm, &group);
+    MPI_Comm_group(node_comm_, &node_group);
+    MPI_Group_translate_ranks(node_group, nlocals, locals.data(), group, ranks.data());
+    MPI_Group_free(&group);
+    MPI_Group_free(&node_group);
+
+    bases_.assign(nranks, (char*) NULL);
+    for (int i = 0; i < nlocals; i++) {
+        MPI_Aint size;
+        int disp;
+        MPI_Win_shared_query(win_, i, &size, &disp, &bases_[ranks[i]]);
+    }
+    _trace("nlocals[%d] size[%lu]", nlocals, size_);
+}
+
+Shm::~Shm() {
+    MPI_Win_unlock_all(win_);
+    MPI_Win_free(&win_);
+    MPI_Comm_free(&node_comm_);
+    pthread_mutex_destroy(&mutex_);
+}
+
+/* Returns NULL when the outbox is full; the caller then goes through MPI. */
+char* Shm::Alloc(size_t size, uint64_t* offp) {
+    char* p = NULL;
+    size = (size + 0xf) & ~0xfUL;
+    pthread_mutex_lock(&mutex_);
+    if (off_ + size <= size_) {
+        p = base_ + off_;
+        *offp = off_;
+        off_ += size;
+        inflight_++;
+    }
+    pthread_mutex_unlock(&mutex_);
+    return p;
+}
+
+void Shm::Free() {
+    pthread_mutex_lock(&mutex_);
+    if (--inflight_ == 0) off_ = 0UL;
+    pthread_mutex_unlock(&mutex_);
+}
+
+void Shm::Sync() {
+    MPI_Win_sync(win_);
+}
+
+} /* namespace papyruskv */
@@ -0,0 +1,44 @@
+#ifndef PAPYRUS_KV_SRC_SHM_H
+#define PAPYRUS_KV_SRC_SHM_H
+
+#include <mpi.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <vector>
+
+namespace papyruskv {
+
+class Platform;
+
+/* Node-local transport for migrations. Every rank owns an outbox segment of
+ * an MPI shared-memory window on its node. A block bound for a co-located
+ * rank is staged in the sender's outbox and only its offset travels in the
+ * MIGRATE message; the owner applies it in place and acks. The outbox is a
+ * bump allocator that rewinds once every staged block has been acked. */
+class Shm {
+public:
+    Shm(Platform* platform);
+    ~Shm();
+
+    bool Local(int rank) const { return bases_[rank] != NULL; }
+    char* Alloc(size_t size, uint64_t* offp);
+    void Free();
+    char* Base(int rank) const { return bases_[rank]; }
+    void Sync();
+
+private:
+    MPI_Comm node_comm_;
+    MPI_Win win_;
+    char* base_;
+    size_t size_;
+    std::vector<char*> bases_;
+
+    size_t off_;
+    int inflight_;
+    pthread_mutex_t mutex_;
+};
+
+} /* namespace papyruskv */
+
+#endif /* PAPYRUS_KV_SRC_SHM_H */
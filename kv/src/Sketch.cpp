@@ -0,0 +1,63 @@
+#include "Sketch.h"
+#include "Utils.h"
+#include <string.h>
+
+namespace papyruskv {
+
+static const uint64_t seeds_[PAPYRUSKV_SKETCH_DEPTH] = {
+    0xc3a5c85c97cb3127ULL, 0xb492b66fbe98f273ULL, 0x9ae16a3b2f90404fULL, 0xcbf29ce484222325ULL
+};
+
+Sketch::Sketch(size_t width) {
+    width_ = Utils::P2(width);
+    if (width_ < PAPYRUSKV_SKETCH_MIN_WIDTH) width_ = PAPYRUSKV_SKETCH_MIN_WIDTH;
+    if (width_ > PAPYRUSKV_SKETCH_MAX_WIDTH) width_ = PAPYRUSKV_SKETCH_MAX_WIDTH;
+    shift_ = 64;
+    for (size_t w = width_; w > 1; w >>= 1) shift_--;
+    table_ = new uint8_t[width_ * PAPYRUSKV_SKETCH_DEPTH / 2]();
+    additions_ = 0UL;
+    sample_ = width_ * 10;
+}
+
+Sketch::~Sketch() {
+    delete[] table_;
+}
+
+size_t Sketch::Index(uint64_t hash, int row) {
+    uint64_t h = (hash ^ (hash >> 32)) * seeds_[row];
+    return row * width_ + (h >> shift_);
+}
+
+void Sketch::Increment(uint64_t hash) {
+    bool added = false;
+    for (int i = 0; i < PAPYRUSKV_SKETCH_DEPTH; i++) {
+        size_t idx = Index(hash, i);
+        uint8_t* counter = table_ + (idx >> 1);
+        int shift = (int) (idx & 1) << 2;
+        uint8_t old = __atomic_load_n(counter, __ATOMIC_RELAXED);
+        while (((old >> shift) & PAPYRUSKV_SKETCH_MAX) < PAPYRUSKV_SKETCH_MAX) {
+            if (__atomic_compare_exchange_n(counter, &old, (uint8_t) (old + (1 << shift)), true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                added = true;
+                break;
+            }
+        }
+    }
+    if (added) __atomic_fetch_add(&additions_, 1, __ATOMIC_RELAXED);
+}
+
+int Sketch::Estimate(uint64_t hash) {
+    int freq = PAPYRUSKV_SKETCH_MAX;
+    for (int i = 0; i < PAPYRUSKV_SKETCH_DEPTH; i++) {
+        size_t idx = Index(hash, i);
+        int count = (__atomic_load_n(table_ + (idx >> 1), __ATOMIC_RELAXED) >> ((idx & 1) << 2)) & PAPYRUSKV_SKETCH_MAX;
+        if (count < freq) freq = count;
+    }
+    return freq;
+}
+
+void Sketch::Age() {
+    for (size_t i = 0; i < width_ * PAPYRUSKV_SKETCH_DEPTH / 2; i++) table_[i] = (table_[i] >> 1) & 0x77;
+    additions_ >>= 1;
+}
+
+} /* namespace papyruskv */
@@ -0,0 +1,47 @@
+#ifndef PAPYRUS_KV_SRC_SKETCH_H
+#define PAPYRUS_KV_SRC_SKETCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define PAPYRUSKV_SKETCH_DEPTH              4
+#define PAPYRUSKV_SKETCH_MAX                15
+#define PAPYRUSKV_SKETCH_MIN_WIDTH          64
+#define PAPYRUSKV_SKETCH_MAX_WIDTH          (1UL << 20)
+
+namespace papyruskv {
+
+/*
+ * Count-min sketch of recent key frequencies for TinyLFU admission. Counters
+ * are 4 bits, packed two per byte, and saturate at 15. They are all halved
+ * once the number of recorded accesses reaches ten times the width, so old
+ * popularity fades. Increment updates each counter with a compare-and-swap
+ * on its byte, so concurrent increments under the stripe's read lock stay
+ * atomic per nibble. Age runs under the stripe's write lock.
+ */
+class Sketch {
+public:
+    Sketch(size_t width);
+    ~Sketch();
+
+    void Increment(uint64_t hash);
+    int Estimate(uint64_t hash);
+    bool Aging() const { return additions_ >= sample_; }
+    void Age();
+
+    size_t size() const { return width_ * PAPYRUSKV_SKETCH_DEPTH / 2; }
+
+private:
+    size_t Index(uint64_t hash, int row);
+
+private:
+    uint8_t* table_;
+    size_t width_;
+    int shift_;
+    size_t additions_;
+    size_t sample_;
+};
+
+} /* namespace papyruskv */
+
+#endif /* PAPYRUS_KV_SRC_SKETCH_H */
@@ -0,0 +1,113 @@
+#include "SkipList.h"
+#include "Arena.h"
+#include "Slice.h"
+#include "Utils.h"
+
+namespace papyruskv {
+
+SkipList::SkipList(Arena* arena) {
+    arena_ = arena;
+    head_ = NewNode(NULL, PAPYRUSKV_SKIPLIST_MAX_HEIGHT);
+    height_ = 1;
+    count_ = 0UL;
+}
+
+SkipList::~SkipList() {
+}
+
+SkipList::Node* SkipList::NewNode(Slice* slice, int height) {
+    Node* node = (Node*) arena_->Allocate(sizeof(Node) + (height - 1) * sizeof(Node*));
+    node->slice = slice;
+    node->height = height;
+    for (int i = 0; i < height; i++) node->next[i] = NULL;
+    return node;
+}
+
+int SkipList::RandomHeight() {
+    static __thread uint32_t seed = 0;
+    if (seed == 0) seed = (uint32_t) (uintptr_t) &seed | 1;
+    int height = 1;
+    while (height < PAPYRUSKV_SKIPLIST_MAX_HEIGHT) {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        if (seed % PAPYRUSKV_SKIPLIST_BRANCHING) break;
+        height++;
+    }
+    return height;
+}
+
+int SkipList::Compare(const Node* node, const char* key, size_t keylen) {
+    Slice* slice = Load(node);
+    return Utils::Compare(slice->key(), slice->keylen(), key, keylen);
+}
+
+SkipList::Node* SkipList::FindGreaterOrEqual(const char* key, size_t keylen, Node** prevs) const {
+    Node* node = head_;
+    for (int level = __atomic_load_n(&height_, __ATOMIC_RELAXED) - 1; level >= 0; level--) {
+        Node* next = Next(node, level);
+        while (next && Compare(next, key, keylen) < 0) {
+            node = next;
+            next = Next(node, level);
+        }
+        if (prevs) prevs[level] = node;
+        if (level == 0) return next;
+    }
+    return NULL;
+}
+
+void SkipList::FindSplice(const char* key, size_t keylen, Node* before, int level, Node** prev, Node** next) const {
+    Node* after = Next(before, level);
+    while (after && Compare(after, key, keylen) < 0) {
+        before = after;
+        after = Next(before, level);
+    }
+    *prev = before;
+    *next = after;
+}
+
+Slice* SkipList::Get(const char* key, size_t keylen) const {
+    Node* node = FindGreaterOrEqual(key, keylen, NULL);
+    if (node && Compare(node, key, keylen) == 0) return Load(node);
+    return NULL;
+}
+
+Slice* SkipList::Swap(Node* node, Slice* slice) {
+    return __atomic_exchange_n(&node->slice, slice, __ATOMIC_ACQ_REL);
+}
+
+Slice* SkipList::Put(Slice* slice) {
+    const char* key = slice->key();
+    size_t keylen = slice->keylen();
+
+    Node* prevs[PAPYRUSKV_SKIPLIST_MAX_HEIGHT];
+    Node* nexts[PAPYRUSKV_SKIPLIST_MAX_HEIGHT];
+    for (int i = 0; i < PAPYRUSKV_SKIPLIST_MAX_HEIGHT; i++) prevs[i] = head_;
+
+    Node* found = FindGreaterOrEqual(key, keylen, prevs);
+    if (found && Compare(found, key, keylen) == 0) return Swap(found, slice);
+
+    int height = RandomHeight();
+    int max_height = __atomic_load_n(&height_, __ATOMIC_RELAXED);
+    while (height > max_height) {
+        if (__atomic_compare_exchange_n(&height_, &max_height, height, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) break;
+    }
+
+    Node* node = NewNode(slice, height);
+    for (int level = 0; level < height; level++) {
+        FindSplice(key, keylen, prevs[level], level, prevs + level, nexts + level);
+        while (true) {
+            if (level == 0 && nexts[0] && Compare(nexts[0], key, keylen) == 0) {
+                // another writer linked the same key first, the node stays unused in the arena
+                return Swap(nexts[0], slice);
+            }
+            node->next[level] = nexts[level];
+            if (__atomic_compare_exchange_n(&prevs[level]->next[level], &nexts[level], node, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) break;
+            FindSplice(key, keylen, prevs[level], level, prevs + level, nexts + level);
+        }
+    }
+    __atomic_fetch_add(&count_, 1, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+} /* namespace papyruskv */
@@ -0,0 +1,67 @@
+#ifndef PAPYRUS_KV_SRC_SKIPLIST_H
+#define PAPYRUS_KV_SRC_SKIPLIST_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define PAPYRUSKV_SKIPLIST_MAX_HEIGHT   12
+#define PAPYRUSKV_SKIPLIST_BRANCHING    4
+
+namespace papyruskv {
+
+class Arena;
+class Slice;
+
+// Concurrent skip list of Slices ordered by key bytes (Utils::Compare).
+// Readers never lock. Writers link new nodes bottom-up with CAS, and a put
+// on an existing key swaps the node's slice and hands the old one back.
+// Nodes are allocated from the owner's arena and never freed individually.
+class SkipList {
+private:
+    struct Node {
+        Slice* slice;
+        int height;
+        Node* next[1];
+    };
+
+public:
+    class Iterator {
+    public:
+        Iterator(const SkipList* list) : node_(list->Next(list->head_, 0)) {}
+        bool Valid() const { return node_ != NULL; }
+        Slice* slice() const { return SkipList::Load(node_); }
+        void Next() { node_ = SkipList::Next(node_, 0); }
+
+    private:
+        Node* node_;
+    };
+
+    SkipList(Arena* arena);
+    ~SkipList();
+
+    Slice* Get(const char* key, size_t keylen) const;
+    Slice* Put(Slice* slice);
+
+    size_t count() const { return __atomic_load_n(&count_, __ATOMIC_RELAXED); }
+
+private:
+    Node* NewNode(Slice* slice, int height);
+    int RandomHeight();
+    Node* FindGreaterOrEqual(const char* key, size_t keylen, Node** prevs) const;
+    void FindSplice(const char* key, size_t keylen, Node* before, int level, Node** prev, Node** next) const;
+    Slice* Swap(Node* node, Slice* slice);
+
+    static Node* Next(const Node* node, int level) { return __atomic_load_n(&node->next[level], __ATOMIC_ACQUIRE); }
+    static Slice* Load(const Node* node) { return __atomic_load_n(&node->slice, __ATOMIC_ACQUIRE); }
+    static int Compare(const Node* node, const char* key, size_t keylen);
+
+private:
+    Arena* arena_;
+    Node* head_;
+    int height_;
+    size_t count_;
+};
+
+} /* namespace papyruskv */
+
+#endif /* PAPYRUS_KV_SRC_SKIPLIST_H */
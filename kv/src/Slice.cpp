@@ -1,7 +1,9 @@
 #include "Slice.h"
+#include "Arena.h"
 #include "Platform.h"
 #include "Debug.h"
 #include <string.h>
+#include <new>
 
 namespace papyruskv {
 
@@ -19,6 +21,25 @@ Slice::Slice(size_t keylen, size_t vallen, int rank, bool tombstone) {
     buc_next_ = NULL;
 
     pool_ = Platform::GetPlatform()->pool();
+    arena_ = false;
+    ref_ = 1;
+}
+
+Slice::Slice(char* buf, size_t keylen, size_t vallen, int rank, bool tombstone) {
+    buf_ = buf;
+    key_ = buf_;
+    val_ = buf_ + keylen;
+    keylen_ = keylen;
+    vallen_ = vallen;
+    rank_ = rank;
+    set_tombstone(tombstone);
+    size_ = keylen_ + vallen_ + 1;
+    next_ = NULL;
+    buc_next_ = NULL;
+
+    pool_ = Platform::GetPlatform()->pool();
+    arena_ = true;
+    ref_ = 1;
 }
 
 Slice::Slice(const char* key, size_t keylen, const char* val, size_t vallen, int rank, bool tombstone) : Slice(keylen, vallen, rank, tombstone) {
@@ -36,7 +57,7 @@ Slice::Slice(const char* key, size_t keylen, size_t vallen, const char** vals, s
 }
 
 Slice::~Slice() {
-    free(buf_);
+    if (!arena_) free(buf_);
 }
 
 void Slice::CopyValue(char** valp, size_t* vallenp) {
@@ -55,27 +76,6 @@ void Slice::CopyIter(papyruskv_iter_t iter) {
     iter->handle = (void*) this;
 }
 
-size_t Slice::Update(const char* val, size_t vallen) {
-    if (vallen == vallen_) {
-        memcpy(val_, val, vallen);
-        return cb();
-    }
-    bool ts = tombstone();
-    char* new_buf;
-    if (posix_memalign((void**) &new_buf, 0x10, keylen_ + vallen + 1) != 0)
-        _error("failed to alloc size[%lu]", keylen_ + vallen + 1);
-    memcpy(new_buf, buf_, keylen_);
-    memcpy(new_buf + keylen_, val, vallen);
-    free(buf_);
-    buf_ = new_buf;
-    key_ = buf_;
-    val_ = buf_ + keylen_;
-    vallen_ = vallen;
-    set_tombstone(ts);
-    size_ = keylen_ + vallen_ + 1;
-    return cb();
-}
-
 bool Slice::Match(const char* key, size_t keylen) {
     return (keylen == keylen_) && (memcmp(key_, key, keylen) == 0);
 }
@@ -85,6 +85,10 @@ void Slice::SetPos(papyruskv_pos_t* pos) {
     pos->handle = this;
 }
 
+void Slice::Retain() {
+    __sync_add_and_fetch(&ref_, 1);
+}
+
 bool Slice::tombstone() const {
     return buf_[keylen_ + vallen_] ==  1;
 }
@@ -93,6 +97,14 @@ void Slice::set_tombstone(bool tombstone) {
     buf_[keylen_ + vallen_] = tombstone ? 1 : 0;
 }
 
+Slice* Slice::Create(Arena* arena, const char* key, size_t keylen, const char* val, size_t vallen, int rank, bool tombstone) {
+    char* mem = arena->Allocate(sizeof(Slice) + keylen + vallen + 1);
+    char* buf = mem + sizeof(Slice);
+    memcpy(buf, key, keylen);
+    if (val != NULL && vallen > 0) memcpy(buf + keylen, val, vallen);
+    return new (mem) Slice(buf, keylen, vallen, rank, tombstone);
+}
+
 Slice* Slice::CreateTombstone(const char* key, size_t keylen, int rank) {
     return new Slice(key, keylen, NULL, 0UL, rank, true);
 }
@@ -101,4 +113,8 @@ Slice* Slice::Duplicate(Slice* slice) {
     return new Slice(slice->key(), slice->keylen(), slice->val(), slice->vallen(), slice->rank(), slice->tombstone());
 }
 
+void Slice::Release(Slice* slice) {
+    if (__sync_sub_and_fetch(&slice->ref_, 1) == 0) delete slice;
+}
+
 } /* namespace papyruskv */
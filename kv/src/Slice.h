@@ -8,18 +8,20 @@
 namespace papyruskv {
 
 class MemTable;
+class Arena;
 
 class Slice {
 public:
     Slice(size_t keylen, size_t vallen, int rank, bool tombstone = false);
     Slice(const char* key, size_t keylen, const char* val, size_t vallen, int rank, bool tombstone = false);
     Slice(const char* key, size_t keylen, size_t vallen, const char** vals, size_t* vallens, size_t bs, int rank, bool tombstone = false);
+    Slice(char* buf, size_t keylen, size_t vallen, int rank, bool tombstone);
     ~Slice();
     void CopyValue(char** valp, size_t* vallenp);
     void CopyIter(papyruskv_iter_t iter);
-    size_t Update(const char* val, size_t vallen);
     bool Match(const char* key, size_t keylen);
     void SetPos(papyruskv_pos_t* pos);
+    void Retain();
 
     char* buf() const { return buf_; }
     char* key() const { return key_; }
@@ -52,10 +54,14 @@ private:
 
     MemTable* mt_;
     Pool* pool_;
+    bool arena_;
+    int ref_;
 
 public:
+    static Slice* Create(Arena* arena, const char* key, size_t keylen, const char* val, size_t vallen, int rank, bool tombstone);
     static Slice* CreateTombstone(const char* key, size_t keylen, int rank);
     static Slice* Duplicate(Slice* slice);
+    static void Release(Slice* slice);
 
 };
 
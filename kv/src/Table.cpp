@@ -0,0 +1,296 @@
+#include "Table.h"
+#include "Bloom.h"
+#include "Define.h"
+#include "Debug.h"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+namespace papyruskv {
+
+Table::Table(int rank, int level, uint64_t sid, int fd_sst, off_t sst_size, slice_idx_t* idxes, size_t idx_cnt, uint64_t* bits, size_t bitslen) {
+    rank_ = rank;
+    level_ = level;
+    sid_ = sid;
+    fd_sst_ = fd_sst;
+    sst_size_ = sst_size;
+    sst_map_ = NULL;
+    idxes_ = idxes;
+    idx_cnt_ = idx_cnt;
+    count_ = idx_cnt;
+    index_ = NULL;
+    index_size_ = 0UL;
+    block_size_ = 0UL;
+    bits_ = bits;
+    bitslen_ = bitslen;
+    size_ = sizeof(Table) + idx_cnt * sizeof(slice_idx_t) + bitslen * sizeof(uint64_t);
+    ref_ = 0;
+    cached_ = false;
+}
+
+Table::Table(int rank, int level, uint64_t sid, int fd_sst, off_t sst_size, char* sst_map, slice_idx_t* idx_map, size_t idx_cnt, uint64_t* bits, size_t bitslen) :
+    Table(rank, level, sid, fd_sst, sst_size, idx_map, idx_cnt, bits, bitslen) {
+    sst_map_ = sst_map;
+}
+
+Table::Table(int rank, int level, uint64_t sid, int fd_sst, off_t sst_size, char* sst_map, table_footer_t* footer, char* index, uint64_t* bits, size_t bitslen) :
+    Table(rank, level, sid, fd_sst, sst_size, NULL, 0UL, bits, bitslen) {
+    sst_map_ = sst_map;
+    count_ = footer->count;
+    index_ = index;
+    index_size_ = footer->index_size;
+    block_size_ = footer->block_size;
+    size_ += index_size_;
+}
+
+Table::~Table() {
+    if (sst_map_) {
+        if (munmap(sst_map_, sst_size_) != 0) _error("sst_map[%p] size[%ld]", sst_map_, sst_size_);
+        if (idxes_ && munmap(idxes_, idx_cnt_ * sizeof(slice_idx_t)) != 0) _error("idx_map[%p] cnt[%lu]", idxes_, idx_cnt_);
+    } else {
+        if (idxes_) delete[] idxes_;
+        if (index_) delete[] index_;
+    }
+    if (bits_) free(bits_);
+    int iret = close(fd_sst_);
+    if (iret != 0) _error("fd[%d] ret[%d]", fd_sst_, iret);
+}
+
+const char* Table::Read(uint64_t off, size_t len, char* buf) {
+    if (sst_map_) return sst_map_ + off;
+    ssize_t ssret = pread(fd_sst_, buf, len, off);
+    if (ssret < 0 || (size_t) ssret != len) _error("ssret[%ld] len[%lu]", ssret, len);
+    return buf;
+}
+
+size_t Table::ValLen(size_t j) {
+    uint64_t end = j == idx_cnt_ - 1 ? sst_size_ : idxes_[j + 1].idx;
+    return end - idxes_[j].idx - idxes_[j].len;
+}
+
+TableIterator::TableIterator(Table* table) {
+    table_ = table;
+    j_ = 0UL;
+    key_ = NULL;
+    keylen_ = 0UL;
+    val_ = NULL;
+    vallen_ = 0UL;
+    tombstone_ = false;
+    buf_ = NULL;
+    buflen_ = 0UL;
+    index_iter_ = table->blocked() ? new BlockIterator(table->index(), table->index_size()) : NULL;
+    block_iter_ = NULL;
+    if (Valid()) Read();
+}
+
+TableIterator::~TableIterator() {
+    if (index_iter_) delete index_iter_;
+    if (block_iter_) delete block_iter_;
+    if (buf_) delete[] buf_;
+}
+
+void TableIterator::Next() {
+    j_++;
+    if (block_iter_) block_iter_->Next();
+    if (Valid()) Read();
+}
+
+char* TableIterator::Buffer(size_t len) {
+    if (table_->mapped()) return NULL;
+    if (len > buflen_) {
+        if (buf_) delete[] buf_;
+        buflen_ = len;
+        buf_ = new char[buflen_];
+    }
+    return buf_;
+}
+
+void TableIterator::Read() {
+    if (index_iter_) {
+        while (block_iter_ == NULL || !block_iter_->Valid()) {
+            if (block_iter_) {
+                delete block_iter_;
+                block_iter_ = NULL;
+                index_iter_->Next();
+            }
+            if (!index_iter_->Valid()) {
+                _error("sid[%lu] j[%lu] count[%lu]", table_->sid(), j_, table_->count());
+                j_ = table_->count();
+                return;
+            }
+            block_handle_t handle;
+            memcpy(&handle, index_iter_->val(), sizeof(handle));
+            const char* block = table_->Read(handle.off, handle.size, Buffer(handle.size));
+            block_iter_ = new BlockIterator(block, handle.size);
+        }
+        key_ = block_iter_->key();
+        keylen_ = block_iter_->keylen();
+        val_ = block_iter_->val();
+        vallen_ = block_iter_->vallen();
+        tombstone_ = block_iter_->tombstone();
+        return;
+    }
+
+    slice_idx_t* si = table_->idxes() + j_;
+    keylen_ = si->len;
+    vallen_ = table_->ValLen(j_);
+    tombstone_ = si->tombstone == 1;
+    size_t kvsize = keylen_ + vallen_;
+    key_ = table_->Read(si->idx, kvsize, Buffer(kvsize));
+    val_ = key_ + keylen_;
+}
+
+/* Data goes out in whole PAPYRUSKV_TABLE_BUFFER writes from a page-aligned
+ * buffer. With direct I/O the table file bypasses the page cache; only the
+ * last, partial write is issued after dropping O_DIRECT. */
+TableBuilder::TableBuilder(const char* idx_path, const char* sst_path, const char* blm_path, Bloom* bloom, uint64_t expected, size_t block_size, bool direct) {
+    ok_ = true;
+    direct_ = direct;
+    block_size_ = block_size;
+    block_ = NULL;
+    index_ = NULL;
+    fd_idx_ = -1;
+    idx_buf_ = NULL;
+    if (block_size_ > 0) {
+        block_ = new BlockBuilder(PAPYRUSKV_BLOCK_RESTART);
+        index_ = new BlockBuilder(1);
+    } else {
+        fd_idx_ = open(idx_path, O_CREAT | O_WRONLY | O_TRUNC, S_IRUSR | S_IWUSR);
+        if (fd_idx_ == -1) {
+            _error("path[%s]", idx_path);
+            ok_ = false;
+        }
+        idx_buf_ = new char[PAPYRUSKV_TABLE_BUFFER];
+    }
+    fd_sst_ = -1;
+    if (direct_) fd_sst_ = open(sst_path, O_CREAT | O_WRONLY | O_TRUNC | O_DIRECT, S_IRUSR | S_IWUSR);
+    if (fd_sst_ == -1) {
+        direct_ = false;
+        fd_sst_ = open(sst_path, O_CREAT | O_WRONLY | O_TRUNC, S_IRUSR | S_IWUSR);
+    }
+    if (fd_sst_ == -1) {
+        _error("path[%s]", sst_path);
+        ok_ = false;
+    }
+    fd_blm_ = -1;
+    bloom_ = bloom;
+    bits_ = NULL;
+    bitslen_ = 0UL;
+    if (blm_path) {
+        fd_blm_ = open(blm_path, O_CREAT | O_WRONLY | O_TRUNC, S_IRUSR | S_IWUSR);
+        if (fd_blm_ == -1) {
+            _error("path[%s]", blm_path);
+            ok_ = false;
+        }
+        bits_ = bloom_->Alloc(expected, &bitslen_);
+    }
+    if (posix_memalign((void**) &sst_buf_, 0x1000, PAPYRUSKV_TABLE_BUFFER) != 0) _error("size[%lu]", PAPYRUSKV_TABLE_BUFFER);
+    idx_len_ = 0UL;
+    sst_len_ = 0UL;
+    off_ = 0UL;
+    count_ = 0UL;
+}
+
+TableBuilder::~TableBuilder() {
+    if (fd_idx_ != -1) close(fd_idx_);
+    if (fd_sst_ != -1) close(fd_sst_);
+    if (fd_blm_ != -1) close(fd_blm_);
+    if (bits_) free(bits_);
+    if (block_) delete block_;
+    if (index_) delete index_;
+    if (idx_buf_) delete[] idx_buf_;
+    free(sst_buf_);
+}
+
+bool TableBuilder::Add(const char* key, size_t keylen, const char* val, size_t vallen, bool tombstone) {
+    if (count_ == 0) min_key_.assign(key, keylen);
+    max_key_.assign(key, keylen);
+    if (block_) {
+        block_->Add(key, keylen, val, vallen, tombstone);
+        if (block_->size() >= block_size_) ok_ &= FlushBlock();
+        if (bits_) bloom_->Add(bits_, key, keylen);
+        count_++;
+        return ok_;
+    }
+    slice_idx_t si = (slice_idx_t) { off_, keylen, tombstone ? (uint8_t) 1 : (uint8_t) 0 };
+    _trace("idx[%lu] len[%lu] tombstone[%d]", si.idx, si.len, si.tombstone);
+    ok_ &= Write(fd_idx_, idx_buf_, &idx_len_, &si, sizeof(si));
+    ok_ &= Write(fd_sst_, sst_buf_, &sst_len_, key, keylen);
+    if (vallen > 0) ok_ &= Write(fd_sst_, sst_buf_, &sst_len_, val, vallen);
+    if (bits_) bloom_->Add(bits_, key, keylen);
+    off_ += keylen + vallen;
+    count_++;
+    return ok_;
+}
+
+bool TableBuilder::Finish() {
+    if (block_) {
+        ok_ &= FlushBlock();
+        size_t len = 0UL;
+        const char* index = index_->Finish(&len);
+        table_footer_t footer = { off_, len, count_, (uint32_t) block_size_, PAPYRUSKV_TABLE_VERSION, PAPYRUSKV_TABLE_MAGIC };
+        ok_ &= Write(fd_sst_, sst_buf_, &sst_len_, index, len);
+        ok_ &= Write(fd_sst_, sst_buf_, &sst_len_, &footer, sizeof(footer));
+        off_ += len + sizeof(footer);
+    }
+    ok_ &= Flush(fd_idx_, idx_buf_, &idx_len_);
+    if (direct_ && sst_len_ > 0 && fcntl(fd_sst_, F_SETFL, fcntl(fd_sst_, F_GETFL) & ~O_DIRECT) == -1) {
+        _error("fd[%d]", fd_sst_);
+        ok_ = false;
+    }
+    ok_ &= Flush(fd_sst_, sst_buf_, &sst_len_);
+    if (bits_) ok_ &= bloom_->Write(fd_blm_, bits_, bitslen_);
+    int fds[3] = { fd_idx_, fd_sst_, fd_blm_ };
+    for (int i = 0; i < 3; i++) {
+        if (fds[i] == -1) continue;
+        int iret = close(fds[i]);
+        if (iret == -1) {
+            _error("ret[%d]", iret);
+            ok_ = false;
+        }
+    }
+    fd_idx_ = fd_sst_ = fd_blm_ = -1;
+    return ok_;
+}
+
+bool TableBuilder::FlushBlock() {
+    if (block_->empty()) return true;
+    size_t len = 0UL;
+    const char* block = block_->Finish(&len);
+    block_handle_t handle = { off_, len };
+    bool ret = Write(fd_sst_, sst_buf_, &sst_len_, block, len);
+    index_->Add(block_->last_key().data(), block_->last_key().size(), (const char*) &handle, sizeof(handle), false);
+    off_ += len;
+    block_->Reset();
+    return ret;
+}
+
+bool TableBuilder::Write(int fd, char* buf, size_t* len, const void* data, size_t size) {
+    const char* p = (const char*) data;
+    while (*len + size > PAPYRUSKV_TABLE_BUFFER) {
+        size_t n = PAPYRUSKV_TABLE_BUFFER - *len;
+        memcpy(buf + *len, p, n);
+        *len += n;
+        if (!Flush(fd, buf, len)) return false;
+        p += n;
+        size -= n;
+    }
+    memcpy(buf + *len, p, size);
+    *len += size;
+    return true;
+}
+
+bool TableBuilder::Flush(int fd, char* buf, size_t* len) {
+    if (*len == 0) return true;
+    ssize_t ssret = write(fd, buf, *len);
+    if (ssret < 0 || (size_t) ssret != *len) {
+        _error("ret[%ld] len[%lu]", ssret, *len);
+        return false;
+    }
+    *len = 0UL;
+    return true;
+}
+
+} /* namespace papyruskv */
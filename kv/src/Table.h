@@ -0,0 +1,171 @@
+#ifndef PAPYRUS_KV_SRC_TABLE_H
+#define PAPYRUS_KV_SRC_TABLE_H
+
+#include "Block.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <string>
+
+#define PAPYRUSKV_TABLE_MAGIC               0x4b434f4c42564b50ULL
+#define PAPYRUSKV_TABLE_VERSION             1
+
+namespace papyruskv {
+
+typedef struct {
+    uint64_t idx;
+    uint64_t len;
+    uint8_t tombstone;
+} slice_idx_t;
+
+typedef struct {
+    int32_t level;
+    uint64_t sid;
+    uint64_t count;
+    uint64_t size;
+    std::string min;
+    std::string max;
+} table_meta_t;
+
+typedef struct {
+    uint64_t off;
+    uint64_t size;
+} block_handle_t;
+
+/* Trailer of a block-based .sst; tables without it use the flat .sst + .idx layout. */
+typedef struct {
+    uint64_t index_off;
+    uint64_t index_size;
+    uint64_t count;
+    uint32_t block_size;
+    uint32_t version;
+    uint64_t magic;
+} table_footer_t;
+
+class Bloom;
+
+class Table {
+public:
+    Table(int rank, int level, uint64_t sid, int fd_sst, off_t sst_size, slice_idx_t* idxes, size_t idx_cnt, uint64_t* bits, size_t bitslen);
+    Table(int rank, int level, uint64_t sid, int fd_sst, off_t sst_size, char* sst_map, slice_idx_t* idx_map, size_t idx_cnt, uint64_t* bits, size_t bitslen);
+    Table(int rank, int level, uint64_t sid, int fd_sst, off_t sst_size, char* sst_map, table_footer_t* footer, char* index, uint64_t* bits, size_t bitslen);
+    ~Table();
+
+    const char* Read(uint64_t off, size_t len, char* buf);
+    size_t ValLen(size_t j);
+
+    int rank() const { return rank_; }
+    int level() const { return level_; }
+    uint64_t sid() const { return sid_; }
+    int fd_sst() const { return fd_sst_; }
+    off_t sst_size() const { return sst_size_; }
+    slice_idx_t* idxes() const { return idxes_; }
+    size_t idx_cnt() const { return idx_cnt_; }
+    uint64_t count() const { return count_; }
+    const char* index() const { return index_; }
+    size_t index_size() const { return index_size_; }
+    size_t block_size() const { return block_size_; }
+    bool blocked() const { return index_ != NULL; }
+    uint64_t* bits() const { return bits_; }
+    size_t bitslen() const { return bitslen_; }
+    size_t size() const { return size_; }
+    bool mapped() const { return sst_map_ != NULL; }
+
+private:
+    int rank_;
+    int level_;
+    uint64_t sid_;
+    int fd_sst_;
+    off_t sst_size_;
+    char* sst_map_;
+    slice_idx_t* idxes_;
+    size_t idx_cnt_;
+    uint64_t count_;
+    char* index_;
+    size_t index_size_;
+    size_t block_size_;
+    uint64_t* bits_;
+    size_t bitslen_;
+    size_t size_;
+
+    int ref_;
+    bool cached_;
+
+    friend class TableCache;
+};
+
+class TableIterator {
+public:
+    TableIterator(Table* table);
+    ~TableIterator();
+
+    bool Valid() const { return j_ < table_->count(); }
+    void Next();
+
+    const char* key() const { return key_; }
+    size_t keylen() const { return keylen_; }
+    const char* val() const { return val_; }
+    size_t vallen() const { return vallen_; }
+    bool tombstone() const { return tombstone_; }
+
+private:
+    void Read();
+    char* Buffer(size_t len);
+
+private:
+    Table* table_;
+    size_t j_;
+    const char* key_;
+    size_t keylen_;
+    const char* val_;
+    size_t vallen_;
+    bool tombstone_;
+    char* buf_;
+    size_t buflen_;
+    BlockIterator* index_iter_;
+    BlockIterator* block_iter_;
+};
+
+class TableBuilder {
+public:
+    TableBuilder(const char* idx_path, const char* sst_path, const char* blm_path, Bloom* bloom, uint64_t expected, size_t block_size, bool direct = false);
+    ~TableBuilder();
+
+    bool Add(const char* key, size_t keylen, const char* val, size_t vallen, bool tombstone);
+    bool Finish();
+
+    uint64_t count() const { return count_; }
+    uint64_t size() const { return off_; }
+    const std::string& min_key() const { return min_key_; }
+    const std::string& max_key() const { return max_key_; }
+
+private:
+    bool Write(int fd, char* buf, size_t* len, const void* data, size_t size);
+    bool Flush(int fd, char* buf, size_t* len);
+    bool FlushBlock();
+
+private:
+    int fd_idx_;
+    int fd_sst_;
+    int fd_blm_;
+    Bloom* bloom_;
+    uint64_t* bits_;
+    size_t bitslen_;
+    char* idx_buf_;
+    size_t idx_len_;
+    char* sst_buf_;
+    size_t sst_len_;
+    uint64_t off_;
+    uint64_t count_;
+    size_t block_size_;
+    BlockBuilder* block_;
+    BlockBuilder* index_;
+    std::string min_key_;
+    std::string max_key_;
+    bool direct_;
+    bool ok_;
+};
+
+} /* namespace papyruskv */
+
+#endif /* PAPYRUS_KV_SRC_TABLE_H */
@@ -0,0 +1,101 @@
+#include "TableCache.h"
+#include "SSTable.h"
+#include "Debug.h"
+
+namespace papyruskv {
+
+TableCache::TableCache(SSTable* sstable, size_t capacity) {
+    sstable_ = sstable;
+    capacity_ = capacity;
+    size_ = 0UL;
+    hit_ = 0UL;
+    miss_ = 0UL;
+    pthread_mutex_init(&mutex_, NULL);
+}
+
+TableCache::~TableCache() {
+    EvictAll();
+    pthread_mutex_destroy(&mutex_);
+
+    if (hit_ + miss_ > 0) {
+        _trace("hit[%lu] miss[%lu] hitratio[%lf]", hit_, miss_, (double) (hit_) / (hit_ + miss_));
+    }
+}
+
+Table* TableCache::Get(int rank, int level, uint64_t sid) {
+    uint64_t key = Key(rank, level, sid);
+
+    pthread_mutex_lock(&mutex_);
+    auto it = table_.find(key);
+    if (it != table_.end()) {
+        hit_++;
+        lru_.splice(lru_.begin(), lru_, it->second);
+        Table* table = *(it->second);
+        table->ref_++;
+        pthread_mutex_unlock(&mutex_);
+        return table;
+    }
+    miss_++;
+    pthread_mutex_unlock(&mutex_);
+
+    Table* table = sstable_->OpenTable(rank, level, sid);
+    if (table == NULL) return NULL;
+
+    pthread_mutex_lock(&mutex_);
+    table->ref_++;
+    it = table_.find(key);
+    if (it == table_.end() && table->size() <= capacity_) {
+        lru_.push_front(table);
+        table_[key] = lru_.begin();
+        table->cached_ = true;
+        size_ += table->size();
+        Shrink();
+    }
+    pthread_mutex_unlock(&mutex_);
+    return table;
+}
+
+void TableCache::Retain(Table* table) {
+    pthread_mutex_lock(&mutex_);
+    table->ref_++;
+    pthread_mutex_unlock(&mutex_);
+}
+
+void TableCache::Release(Table* table) {
+    pthread_mutex_lock(&mutex_);
+    bool drop = --table->ref_ == 0 && !table->cached_;
+    pthread_mutex_unlock(&mutex_);
+    if (drop) delete table;
+}
+
+void TableCache::Evict(int rank, int level, uint64_t sid) {
+    pthread_mutex_lock(&mutex_);
+    auto it = table_.find(Key(rank, level, sid));
+    if (it != table_.end()) Evict(it->second);
+    pthread_mutex_unlock(&mutex_);
+}
+
+void TableCache::EvictAll() {
+    pthread_mutex_lock(&mutex_);
+    while (!lru_.empty()) Evict(lru_.begin());
+    pthread_mutex_unlock(&mutex_);
+}
+
+void TableCache::Evict(iter_t it) {
+    Table* table = *it;
+    table_.erase(Key(table->rank(), table->level(), table->sid()));
+    lru_.erase(it);
+    size_ -= table->size();
+    table->cached_ = false;
+    if (table->ref_ == 0) delete table;
+}
+
+void TableCache::Shrink() {
+    while (size_ > capacity_ && !lru_.empty()) {
+        auto last = lru_.end();
+        last--;
+        Evict(last);
+    }
+}
+
+} /* namespace papyruskv */
@@ -0,0 +1,51 @@
+#ifndef PAPYRUS_KV_SRC_TABLECACHE_H
+#define PAPYRUS_KV_SRC_TABLECACHE_H
+
+#include <pthread.h>
+#include <stdint.h>
+#include <unordered_map>
+#include <list>
+#include "Table.h"
+
+namespace papyruskv {
+
+class SSTable;
+
+class TableCache {
+public:
+    typedef std::list<Table*>::iterator iter_t;
+
+    TableCache(SSTable* sstable, size_t capacity);
+    ~TableCache();
+
+    Table* Get(int rank, int level, uint64_t sid);
+    void Retain(Table* table);
+    void Release(Table* table);
+    void Evict(int rank, int level, uint64_t sid);
+    void EvictAll();
+
+    size_t size() const { return size_; }
+
+private:
+    void Evict(iter_t it);
+    void Shrink();
+
+    uint64_t Key(int rank, int level, uint64_t sid) { return ((uint64_t) rank << 44) | ((uint64_t) level << 40) | sid; }
+
+private:
+    SSTable* sstable_;
+    size_t capacity_;
+    size_t size_;
+
+    size_t hit_;
+    size_t miss_;
+
+    std::list<Table*> lru_;
+    std::unordered_map<uint64_t, iter_t> table_;
+
+    pthread_mutex_t mutex_;
+};
+
+} /* namespace papyruskv */
+
+#endif /* PAPYRUS_KV_SRC_TABLECACHE_H */
@@ -73,6 +73,12 @@ static int Rmdir(const char* path) {
     return r;
 }
 
+static int Compare(const char* k1, size_t k1len, const char* k2, size_t k2len) {
+    int cmp = memcmp(k1, k2, k1len < k2len ? k1len : k2len);
+    if (cmp != 0) return cmp;
+    return k1len < k2len ? -1 : k1len > k2len ? 1 : 0;
+}
+
 static size_t P2(size_t size) {
     size_t p2 = 1;
     while (p2 < size) p2 = p2 << 1;
@@ -0,0 +1,55 @@
+#include "View.h"
+#include "MemTable.h"
+#include "Pool.h"
+#include "Slice.h"
+#include "TableCache.h"
+
+namespace papyruskv {
+
+View::View(Pool* pool) {
+    pool_ = pool;
+    mt_ = NULL;
+    slice_ = NULL;
+    table_cache_ = NULL;
+    table_ = NULL;
+    buf_ = NULL;
+    val_ = NULL;
+    vallen_ = 0UL;
+}
+
+View::~View() {
+    if (mt_) MemTable::Release(mt_);
+    else if (slice_) Slice::Release(slice_);
+    if (table_) table_cache_->Release(table_);
+    if (buf_) pool_->FreeVal(&buf_);
+}
+
+void View::Pin(MemTable* mt, Slice* slice) {
+    mt->Retain();
+    mt_ = mt;
+    val_ = slice->val();
+    vallen_ = slice->vallen();
+}
+
+void View::Pin(Slice* slice) {
+    slice->Retain();
+    slice_ = slice;
+    val_ = slice->val();
+    vallen_ = slice->vallen();
+}
+
+void View::Pin(TableCache* table_cache, Table* table, const char* val, size_t vallen) {
+    table_cache->Retain(table);
+    table_cache_ = table_cache;
+    table_ = table;
+    val_ = val;
+    vallen_ = vallen;
+}
+
+void View::Own(char* val, size_t vallen) {
+    buf_ = val;
+    val_ = val;
+    vallen_ = vallen;
+}
+
+} /* namespace papyruskv */
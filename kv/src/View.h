@@ -0,0 +1,43 @@
+#ifndef PAPYRUS_KV_SRC_VIEW_H
+#define PAPYRUS_KV_SRC_VIEW_H
+
+#include <stddef.h>
+
+namespace papyruskv {
+
+class MemTable;
+class Slice;
+class Table;
+class TableCache;
+class Pool;
+
+/* A borrowed value: points into a memtable slice, a cache entry, or a mapped
+ * SSTable, and keeps its owner alive until the view is released. Values that
+ * are not resident (remote or unmapped tables) are copied into a pool buffer. */
+class View {
+public:
+    View(Pool* pool);
+    ~View();
+
+    void Pin(MemTable* mt, Slice* slice);
+    void Pin(Slice* slice);
+    void Pin(TableCache* table_cache, Table* table, const char* val, size_t vallen);
+    void Own(char* val, size_t vallen);
+
+    const char* val() const { return val_; }
+    size_t vallen() const { return vallen_; }
+
+private:
+    Pool* pool_;
+    MemTable* mt_;
+    Slice* slice_;
+    TableCache* table_cache_;
+    Table* table_;
+    char* buf_;
+    const char* val_;
+    size_t vallen_;
+};
+
+} /* namespace papyruskv */
+
+#endif /* PAPYRUS_KV_SRC_VIEW_H */
@@ -0,0 +1,175 @@
+#include "Window.h"
+#include "DB.h"
+#include "Debug.h"
+#include "MemTable.h"
+#include "Platform.h"
+#include "Slice.h"
+#include <stdlib.h>
+#include <string.h>
+
+namespace papyruskv {
+
+static size_t EntrySize(size_t keylen, size_t vallen) {
+    return (sizeof(window_entry_t) + keylen + vallen + 0x7) & ~0x7UL;
+}
+
+Window::Window(DB* db) {
+    db_ = db;
+    hasher_ = db->hasher();
+    pool_ = db->platform()->pool();
+    nranks_ = db->nranks();
+    image_ = NULL;
+    image_size_ = 0UL;
+    peers_.resize(nranks_);
+    memset(peers_.data(), 0, nranks_ * sizeof(window_desc_t));
+    pthread_mutex_init(&mutex_, NULL);
+
+    MPI_Win_create_dynamic(MPI_INFO_NULL, db->mpi_comm(), &win_);
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, win_);
+
+    if (posix_memalign((void**) &desc_, 0x40, sizeof(window_desc_t)) != 0) _error("size[%lu]", sizeof(window_desc_t));
+    memset(desc_, 0, sizeof(window_desc_t));
+    MPI_Win_attach(win_, desc_, sizeof(window_desc_t));
+
+    MPI_Aint addr;
+    MPI_Get_address(desc_, &addr);
+    addrs_ = new MPI_Aint[nranks_];
+    MPI_Allgather(&addr, 1, MPI_AINT, addrs_, 1, MPI_AINT, db->mpi_comm());
+}
+
+Window::~Window() {
+    Withdraw();
+    MPI_Win_unlock_all(win_);
+    MPI_Win_detach(win_, desc_);
+    MPI_Win_free(&win_);
+    free(desc_);
+    delete[] addrs_;
+    pthread_mutex_destroy(&mutex_);
+}
+
+void Window::Expose(MemTable* mt) {
+    if (image_ || mt->bucket() == NULL) return;
+
+    Slice** bucket = mt->bucket();
+    size_t nbuckets = mt->bucket_size();
+    size_t size = (1 + nbuckets) * sizeof(uint64_t);
+    for (size_t i = 0; i < nbuckets; i++)
+        for (Slice* slice = bucket[i]; slice; slice = slice->buc_next())
+            size += EntrySize(slice->keylen(), slice->vallen());
+
+    if (posix_memalign((void**) &image_, 0x1000, size) != 0) {
+        _error("size[%lu]", size);
+        image_ = NULL;
+        return;
+    }
+    uint64_t* offs = (uint64_t*) image_;
+    offs[0] = nbuckets;
+    uint64_t off = (1 + nbuckets) * sizeof(uint64_t);
+    for (size_t i = 0; i < nbuckets; i++) {
+        uint64_t* link = offs + 1 + i;
+        for (Slice* slice = bucket[i]; slice; slice = slice->buc_next()) {
+            window_entry_t* entry = (window_entry_t*) (image_ + off);
+            entry->next = 0UL;
+            entry->keylen = slice->keylen();
+            entry->vallen = slice->vallen();
+            entry->tombstone = slice->tombstone();
+            memcpy(image_ + off + sizeof(window_entry_t), slice->key(), slice->keylen());
+            if (slice->vallen()) memcpy(image_ + off + sizeof(window_entry_t) + slice->keylen(), slice->val(), slice->vallen());
+            *link = off;
+            link = &entry->next;
+            off += EntrySize(slice->keylen(), slice->vallen());
+        }
+        *link = 0UL;
+    }
+    image_size_ = size;
+
+    MPI_Win_attach(win_, image_, image_size_);
+    MPI_Aint base;
+    MPI_Get_address(image_, &base);
+    desc_->size = image_size_;
+    desc_->nbuckets = nbuckets;
+    __sync_synchronize();
+    desc_->base = (uint64_t) base;
+    MPI_Win_sync(win_);
+    _trace("base[%p] size[%lu] nbuckets[%lu]", image_, image_size_, nbuckets);
+}
+
+/* Called once all ranks have left the read-only phase, so nobody is reading
+ * the image and every cached peer descriptor is stale. */
+void Window::Withdraw() {
+    pthread_mutex_lock(&mutex_);
+    memset(peers_.data(), 0, nranks_ * sizeof(window_desc_t));
+    pthread_mutex_unlock(&mutex_);
+    if (image_ == NULL) return;
+    desc_->base = 0UL;
+    MPI_Win_sync(win_);
+    MPI_Win_detach(win_, image_);
+    free(image_);
+    image_ = NULL;
+    image_size_ = 0UL;
+}
+
+/* Returns PAPYRUSKV_SLICE_NOT_FOUND when the key is not in the image or the
+ * rank has not exposed one yet; the caller then falls back to the listener. */
+int Window::Get(const char* key, size_t keylen, char** valp, size_t* vallenp, int rank) {
+    pthread_mutex_lock(&mutex_);
+    window_desc_t desc = peers_[rank];
+    pthread_mutex_unlock(&mutex_);
+    if (desc.base == 0UL) {
+        if (!Fetch(&desc, sizeof(desc), rank, addrs_[rank]) || desc.base == 0UL) return PAPYRUSKV_SLICE_NOT_FOUND;
+        pthread_mutex_lock(&mutex_);
+        peers_[rank] = desc;
+        pthread_mutex_unlock(&mutex_);
+    }
+
+    uint64_t off = 0UL;
+    size_t idx = hasher_->KeyBucket(key, keylen, desc.nbuckets);
+    if (!Fetch(&off, sizeof(off), rank, desc.base + (1 + idx) * sizeof(uint64_t))) return PAPYRUSKV_SLICE_NOT_FOUND;
+
+    char peek[PAPYRUSKV_WINDOW_PEEK] __attribute__ ((aligned(0x10)));
+    while (off) {
+        size_t len = desc.size - off < PAPYRUSKV_WINDOW_PEEK ? desc.size - off : PAPYRUSKV_WINDOW_PEEK;
+        if (!Fetch(peek, len, rank, desc.base + off)) return PAPYRUSKV_SLICE_NOT_FOUND;
+        window_entry_t* entry = (window_entry_t*) peek;
+        size_t avail = len - sizeof(window_entry_t);
+        if (entry->keylen != keylen) {
+            off = entry->next;
+            continue;
+        }
+
+        bool match;
+        if (keylen <= avail) match = memcmp(peek + sizeof(window_entry_t), key, keylen) == 0;
+        else {
+            char* k = new char[keylen];
+            match = Fetch(k, keylen, rank, desc.base + off + sizeof(window_entry_t)) && memcmp(k, key, keylen) == 0;
+            delete[] k;
+        }
+        if (!match) {
+            off = entry->next;
+            continue;
+        }
+        if (entry->tombstone) return PAPYRUSKV_SLICE_TOMBSTONE;
+
+        size_t vallen = entry->vallen;
+        if (vallenp) *vallenp = vallen;
+        if (valp) {
+            if (*valp == NULL) *valp = pool_->AllocVal(vallen);
+            size_t head = avail > keylen ? avail - keylen : 0UL;
+            if (head > vallen) head = vallen;
+            memcpy(*valp, peek + sizeof(window_entry_t) + keylen, head);
+            if (head < vallen && !Fetch(*valp + head, vallen - head, rank, desc.base + off + sizeof(window_entry_t) + keylen + head))
+                return PAPYRUSKV_SLICE_NOT_FOUND;
+        }
+        return PAPYRUSKV_SLICE_FOUND;
+    }
+    return PAPYRUSKV_SLICE_NOT_FOUND;
+}
+
+bool Window::Fetch(void* dst, size_t size, int rank, uint64_t addr) {
+    int ret = MPI_Get(dst, (int) size, MPI_CHAR, rank, (MPI_Aint) addr, (int) size, MPI_CHAR, win_);
+    if (ret == MPI_SUCCESS) ret = MPI_Win_flush(rank, win_);
+    if (ret != MPI_SUCCESS) _error("ret[%d] rank[%d] addr[0x%lx] size[%lu]", ret, rank, addr, size);
+    return ret == MPI_SUCCESS;
+}
+
+} /* namespace papyruskv */
@@ -0,0 +1,70 @@
+#ifndef PAPYRUS_KV_SRC_WINDOW_H
+#define PAPYRUS_KV_SRC_WINDOW_H
+
+#include <mpi.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <vector>
+
+namespace papyruskv {
+
+class DB;
+class Hasher;
+class MemTable;
+class Pool;
+
+/* Where a rank's image lives; base is 0 until the rank has exposed one. */
+typedef struct {
+    uint64_t base;
+    uint64_t size;
+    uint64_t nbuckets;
+} window_desc_t;
+
+/* Per-entry header in the image, followed by the key and value. Offsets are
+ * relative to the image base and 0 terminates a chain. */
+typedef struct {
+    uint64_t next;
+    uint64_t keylen;
+    uint64_t vallen;
+    uint64_t tombstone;
+} window_entry_t;
+
+/* Exposes the hashed local memtable of a RDONLY DB in a dynamic MPI window,
+ * so peers read it with MPI_Get instead of asking the owner's listener.
+ * The image is a flat copy of the bucket array and the slices it chains:
+ * [nbuckets][bucket offsets][entries]. Creating and freeing the window is
+ * collective; exposing and withdrawing an image is local. */
+class Window {
+public:
+    Window(DB* db);
+    ~Window();
+
+    void Expose(MemTable* mt);
+    void Withdraw();
+    int Get(const char* key, size_t keylen, char** valp, size_t* vallenp, int rank);
+
+    bool exposed() const { return image_ != NULL; }
+
+private:
+    bool Fetch(void* dst, size_t size, int rank, uint64_t addr);
+
+private:
+    DB* db_;
+    Hasher* hasher_;
+    Pool* pool_;
+    int nranks_;
+    MPI_Win win_;
+
+    window_desc_t* desc_;
+    MPI_Aint* addrs_;
+    std::vector<window_desc_t> peers_;
+    pthread_mutex_t mutex_;
+
+    char* image_;
+    size_t image_size_;
+};
+
+} /* namespace papyruskv */
+
+#endif /* PAPYRUS_KV_SRC_WINDOW_H */
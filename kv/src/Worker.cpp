@@ -0,0 +1,302 @@
+#include "Worker.h"
+#include "Platform.h"
+#include "Debug.h"
+#include "Utils.h"
+#include <stdlib.h>
+#include <string.h>
+
+namespace papyruskv {
+
+Worker::Worker(Platform* platform) {
+    platform_ = platform;
+    mpi_comm_ = platform->mpi_comm();
+    mpi_comm_ext_ = platform->mpi_comm_ext();
+    group_ = platform->group();
+    pool_ = platform->pool();
+    queue_ = new LockFreeQueue<Message*>(PAPYRUSKV_LISTENER_QUEUE + 1);
+    sem_init(&slots_, 0, PAPYRUSKV_LISTENER_QUEUE);
+    big_buffer_ = NULL;
+    big_buffer_size_ = 0UL;
+    if (posix_memalign((void**) &ret_buffer_, 0x1000, sizeof(int)) != 0) _error("size[%lu]", sizeof(int));
+}
+
+Worker::~Worker() {
+    Stop();
+    Progress(true);
+    sem_destroy(&slots_);
+    delete queue_;
+    if (big_buffer_) free(big_buffer_);
+    if (ret_buffer_) free(ret_buffer_);
+}
+
+char* Worker::Buffer(size_t size) {
+    if (size <= big_buffer_size_) return big_buffer_;
+    if (big_buffer_) free(big_buffer_);
+    size = Utils::P2(size < PAPYRUSKV_WORKER_BUFFER ? PAPYRUSKV_WORKER_BUFFER : size);
+    if (posix_memalign((void**) &big_buffer_, 0x1000, size) != 0) {
+        _error("size[%lu]", size);
+        big_buffer_ = NULL;
+        size = 0UL;
+    }
+    big_buffer_size_ = size;
+    return big_buffer_;
+}
+
+/* Retires the value sends that have completed, or all of them on wait. */
+void Worker::Progress(bool wait) {
+    for (size_t i = 0; i < sends_.size(); ) {
+        int flag = 1;
+        if (wait) MPI_Wait(&sends_[i].request, MPI_STATUS_IGNORE);
+        else MPI_Test(&sends_[i].request, &flag, MPI_STATUS_IGNORE);
+        if (!flag) {
+            i++;
+            continue;
+        }
+        pool_->FreeVal(&sends_[i].val);
+        sends_[i] = sends_.back();
+        sends_.pop_back();
+    }
+}
+
+void Worker::Enqueue(Message* msg) {
+    sem_wait(&slots_);
+    queue_->Enqueue(msg);
+    Invoke();
+}
+
+/* Requests queued before Stop() are still served. */
+void Worker::Run() {
+    while (true) {
+        sem_wait(&sem_);
+        Message* msg = NULL;
+        while (queue_->Dequeue(&msg)) {
+            sem_post(&slots_);
+            Execute(*msg, msg->source());
+            delete msg;
+        }
+        if (!running_) break;
+    }
+}
+
+void Worker::Execute(Message& msg, int rank) {
+    if (!sends_.empty()) Progress(false);
+    int header = msg.ReadHeader();
+    _trace("header[0x%x] rank[%d]", header, rank);
+    switch (header) {
+        case PAPYRUSKV_MSG_PUT:         ExecutePut(msg, rank);      break;
+        case PAPYRUSKV_MSG_GET:         ExecuteGet(msg, rank);      break;
+        case PAPYRUSKV_MSG_GET_BATCH:   ExecuteGetBatch(msg, rank); break;
+        case PAPYRUSKV_MSG_MIGRATE:     ExecuteMigrate(msg, rank);  break;
+        case PAPYRUSKV_MSG_SIGNAL:      ExecuteSignal(msg, rank);   break;
+        case PAPYRUSKV_MSG_BARRIER:     ExecuteBarrier(msg, rank);  break;
+        case PAPYRUSKV_MSG_UPDATE:      ExecuteUpdate(msg, rank);   break;
+        default: _error("not supported message header[0x%x]", header);
+    }
+}
+
+void Worker::ExecutePut(Message& msg, int rank) {
+    unsigned long dbid = msg.ReadULong();
+    int tag = msg.ReadInt();
+    size_t keylen = msg.ReadULong();
+    size_t vallen = msg.ReadULong();
+    bool tombstone = msg.ReadBool();
+    bool sync = msg.ReadBool();
+
+    char* buf = Buffer(keylen + vallen);
+    MPI_Recv(buf, (int) (keylen + vallen), MPI_CHAR, rank, tag, mpi_comm_, MPI_STATUS_IGNORE);
+    char* key = buf;
+    char* val = buf + keylen;
+    _trace("rank[%d] dbid[%lu] tag[%d] key[%s] keylen[%lu] val[%s] vallen[%lu] tombstone[%d] sync[%d]", rank, dbid, tag, key, keylen, val, vallen, tombstone, sync);
+
+    DB* db = platform_->GetDB(dbid);
+    int ret = db->PutLocal(key, keylen, val, vallen, tombstone);
+    if (ret != PAPYRUSKV_OK) _error("ret[%d]", ret);
+
+    if (sync) {
+        *ret_buffer_ = ret;
+        MPI_Send(ret_buffer_, 1, MPI_INT, rank, tag, mpi_comm_ext_);
+    }
+}
+
+void Worker::ExecuteGet(Message& msg, int rank) {
+    unsigned long dbid = msg.ReadULong();
+    int tag = msg.ReadInt();
+    size_t keylen = msg.ReadULong();
+    char* key = msg.ReadString(keylen);
+    char* valp = (char*) msg.ReadPtr();
+    int group = msg.ReadInt();
+
+    _trace("dbid[%lu] tag[%d] key[%s] keylen[%lu] group[%d]", dbid, tag, key, keylen, group);
+
+    DB* db = platform_->GetDB(dbid);
+    char* buf = Buffer(PAPYRUSKV_GET_PACKET * sizeof(size_t) + db->get_eager());
+    char* val = NULL;
+    size_t vallen = 0UL;
+    int mode = group_ == group ? PAPYRUSKV_MEMTABLE : PAPYRUSKV_MEMTABLE | PAPYRUSKV_SSTABLE;
+    papyruskv_pos_t pos;
+    uint64_t epoch = db->epoch();
+    int ret = db->GetLocal(key, keylen, &val, &vallen, mode, &pos);
+    _trace("ret[%d] key[%s]", ret, key);
+
+    size_t* packet = (size_t*) buf;
+    packet[0] = (size_t) ret;
+    packet[1] = (size_t) mode;
+    packet[2] = vallen;
+    packet[3] = db->sstable()->sid();
+    packet[4] = (size_t) pos.handle;
+    packet[5] = epoch;
+    packet[6] = db->sstable()->version();
+
+    // values up to the eager limit ride with the header, larger ones follow it.
+    // An iget requester only receives the value when it waits on the event,
+    // so the worker must not block on it.
+    bool send = ret == PAPYRUSKV_SLICE_FOUND && valp;
+    bool eager = send && vallen <= db->get_eager();
+    if (eager) memcpy(buf + PAPYRUSKV_GET_PACKET * sizeof(size_t), val, vallen);
+    MPI_Send(buf, (int) (PAPYRUSKV_GET_PACKET * sizeof(size_t) + (eager ? vallen : 0)), MPI_CHAR, rank, tag, mpi_comm_ext_);
+    if (send && !eager) {
+        worker_send_t s;
+        s.val = val;
+        MPI_Isend(val, (int) vallen, MPI_CHAR, rank, tag, mpi_comm_ext_, &s.request);
+        sends_.push_back(s);
+    } else if (val) pool_->FreeVal(&val);
+}
+
+void Worker::ExecuteGetBatch(Message& msg, int rank) {
+    unsigned long dbid = msg.ReadULong();
+    int tag = msg.ReadInt();
+    int group = msg.ReadInt();
+    size_t count = msg.ReadULong();
+    size_t size = msg.ReadULong();
+
+    _trace("dbid[%lu] tag[%d] group[%d] count[%lu] size[%lu]", dbid, tag, group, count, size);
+
+    // keys arrive in the upper half of the buffer, the reply is packed into the lower half
+    const size_t half = PAPYRUSKV_BIG_BUFFER / 2;
+    char* buf = Buffer(PAPYRUSKV_BIG_BUFFER);
+    char* keys = buf + half;
+    MPI_Recv(keys, (int) size, MPI_CHAR, rank, tag, mpi_comm_, MPI_STATUS_IGNORE);
+
+    DB* db = platform_->GetDB(dbid);
+    int mode = group_ == group ? PAPYRUSKV_MEMTABLE : PAPYRUSKV_MEMTABLE | PAPYRUSKV_SSTABLE;
+    uint64_t epoch = db->epoch();
+    size_t avail = half - 3 * sizeof(size_t) - count * 3 * sizeof(size_t);
+    size_t off = 3 * sizeof(size_t);
+    for (size_t i = 0, koff = 0; i < count; i++) {
+        size_t keylen = *((size_t*) (keys + koff));
+        koff += sizeof(size_t);
+        char* key = keys + koff;
+        koff += keylen;
+
+        char* val = NULL;
+        size_t vallen = 0UL;
+        int ret = db->GetLocal(key, keylen, &val, &vallen, mode, NULL);
+        if (ret == PAPYRUSKV_SLICE_FOUND && vallen > avail) ret = PAPYRUSKV_SLICE_RETRY;
+        _trace("ret[%d] key[%s] vallen[%lu]", ret, key, vallen);
+
+        size_t* packet = (size_t*) (buf + off);
+        packet[0] = (size_t) ret;
+        packet[1] = (size_t) mode;
+        packet[2] = vallen;
+        off += 3 * sizeof(size_t);
+        if (ret == PAPYRUSKV_SLICE_FOUND) {
+            memcpy(buf + off, val, vallen);
+            off += vallen;
+            avail -= vallen;
+        }
+        if (val) pool_->FreeVal(&val);
+    }
+    ((size_t*) buf)[0] = db->sstable()->sid();
+    ((size_t*) buf)[1] = epoch;
+    ((size_t*) buf)[2] = db->sstable()->version();
+
+    MPI_Send(buf, (int) off, MPI_CHAR, rank, tag, mpi_comm_ext_);
+}
+
+void Worker::ExecuteMigrate(Message& msg, int rank) {
+    unsigned long dbid = msg.ReadULong();
+    int tag = msg.ReadInt();
+    bool sync = msg.ReadBool();
+    int level = msg.ReadInt();
+    size_t size = msg.ReadULong();
+    uint64_t shm_off = msg.ReadULong();
+
+    DB* db = platform_->GetDB(dbid);
+
+    /* staged blocks are applied straight from the sender's outbox */
+    char* block = NULL;
+    if (shm_off != PAPYRUSKV_SHM_NONE) {
+        Shm* shm = platform_->shm();
+        shm->Sync();
+        block = shm->Base(rank) + shm_off;
+    } else {
+        block = Buffer(size);
+        MPI_Recv(block, (int) size, MPI_CHAR, rank, tag, mpi_comm_, MPI_STATUS_IGNORE);
+    }
+    int ret = PAPYRUSKV_OK;
+    for (size_t off = 0UL; off < size; ) {
+        size_t keylen = *((size_t*) (block + off));
+        off += sizeof(size_t);
+        size_t vallen = *((size_t*) (block + off));
+        off += sizeof(size_t);
+        char* key = block + off;
+        off += keylen;
+        char* val = block + off;
+        off += vallen;
+        bool tombstone = *(block + off) == 1;
+        off += 1;
+        ret = db->PutLocal(key, keylen, val, vallen, tombstone);
+    }
+
+    if (level & PAPYRUSKV_SSTABLE) {
+        ret = db->Flush(sync);
+        if (ret != PAPYRUSKV_OK) _error("ret[%d]", ret);
+    }
+
+    *ret_buffer_ = ret;
+    MPI_Send(ret_buffer_, 1, MPI_INT, rank, tag, mpi_comm_ext_);
+}
+
+void Worker::ExecuteSignal(Message& msg, int rank) {
+    int signum = msg.ReadInt();
+    Signal* signal = platform_->signal();
+    signal->Action(signum, rank);
+}
+
+void Worker::ExecuteBarrier(Message& msg, int) {
+    unsigned long dbid = msg.ReadULong();
+    int level = msg.ReadInt();
+    _trace("dbid[%lu] level[0x%x]", dbid, level);
+    Command* cmd = (Command*) msg.ReadPtr();
+    if (level & PAPYRUSKV_SSTABLE) {
+        DB* db = platform_->GetDB(dbid);
+        int ret = db->Flush(true);
+        if (ret != PAPYRUSKV_OK) _error("ret[%d]", ret);
+    }
+    cmd->Complete();
+}
+
+void Worker::ExecuteUpdate(Message& msg, int rank) {
+    unsigned long dbid = msg.ReadULong();
+    int tag = msg.ReadInt();
+    size_t keylen = msg.ReadULong();
+    char* key = msg.ReadString(keylen);
+    void* pos_handle = msg.ReadPtr();
+    int fnid = msg.ReadInt();
+    size_t userinlen = msg.ReadULong();
+    void* userin = userinlen == 0 ? NULL : msg.Read(userinlen);
+    size_t useroutlen = msg.ReadULong();
+
+    _trace("dbid[%lu] tag[%d] key[%s] keylen[%lu] fnid[%x] userinlen[%lu] useroutlen[%lu]", dbid, tag, key, keylen, fnid, userinlen, useroutlen);
+
+    DB* db = platform_->GetDB(dbid);
+    papyruskv_pos_t pos = { pos_handle };
+    char* buf = Buffer(sizeof(int) + useroutlen);
+    int ret = db->UpdateLocal(key, keylen, &pos, fnid, userin, userinlen, buf + sizeof(int), useroutlen);
+    if (ret != PAPYRUSKV_OK) _error("ret[%d] key[%s] keylen[%lu] fnid[%x]", ret, key, keylen, fnid);
+    ((int*) buf)[0] = ret;
+    if (useroutlen) MPI_Send(buf, (int) useroutlen + sizeof(int), MPI_CHAR, rank, tag, mpi_comm_ext_);
+    else MPI_Send(buf, 1, MPI_INT, rank, tag, mpi_comm_ext_);
+}
+
+} /* namespace papyruskv */
@@ -0,0 +1,65 @@
+#ifndef PAPYRUS_KV_SRC_WORKER_H
+#define PAPYRUS_KV_SRC_WORKER_H
+
+#include <mpi.h>
+#include "Thread.h"
+#include "Message.h"
+#include "Queue.h"
+#include "Pool.h"
+#include <vector>
+
+namespace papyruskv {
+
+class Platform;
+
+/* A value still on its way to a requester and the pool buffer it lives in. */
+typedef struct {
+    MPI_Request request;
+    char* val;
+} worker_send_t;
+
+/* Serves the requests the listener hands over. Each worker owns its reply
+ * buffers, so workers run GetLocal, migrations and updates concurrently.
+ * The big buffer is only allocated, and grown, when a request needs it.
+ * Enqueue blocks the listener while PAPYRUSKV_LISTENER_QUEUE requests are
+ * pending, rather than spinning on the full queue. */
+class Worker : public Thread {
+public:
+    Worker(Platform* platform);
+    virtual ~Worker();
+
+    void Enqueue(Message* msg);
+    void Execute(Message& msg, int rank);
+
+private:
+    void ExecutePut(Message& msg, int rank);
+    void ExecuteGet(Message& msg, int rank);
+    void ExecuteGetBatch(Message& msg, int rank);
+    void ExecuteMigrate(Message& msg, int rank);
+    void ExecuteSignal(Message& msg, int rank);
+    void ExecuteBarrier(Message& msg, int rank);
+    void ExecuteUpdate(Message& msg, int rank);
+
+private:
+    virtual void Run();
+    char* Buffer(size_t size);
+    void Progress(bool wait);
+
+private:
+    Platform* platform_;
+    MPI_Comm mpi_comm_;
+    MPI_Comm mpi_comm_ext_;
+    Pool* pool_;
+    LockFreeQueue<Message*>* queue_;
+    sem_t slots_;
+    char* big_buffer_;
+    size_t big_buffer_size_;
+    int* ret_buffer_;
+    std::vector<worker_send_t> sends_;
+
+    int group_;
+};
+
+} /* namespace papyruskv */
+
+#endif /* PAPYRUS_KV_SRC_WORKER_H */
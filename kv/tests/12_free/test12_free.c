@@ -52,6 +52,12 @@ int main(int argc, char** argv) {
     if (val) ret = papyruskv_free(&val);
     if (ret != PAPYRUSKV_OK) printf("[%s:%d] ERROR:ret[%d] val[%p]\n", __FILE__, __LINE__, ret, val);
 
+    papyruskv_pool_stat_t stat;
+    ret = papyruskv_pool_stat(&stat);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+    printf("[%s:%d] POOL:rank[%d] hits[%lu] misses[%lu] large[%lu] frees[%lu]\n", __FILE__, __LINE__, rank, stat.hits, stat.misses, stat.large, stat.frees);
+    if (peer < sizeof(k) / sizeof(char*) && (stat.frees == 0 || stat.hits + stat.misses + stat.large == 0)) printf("[%s:%d] FAILED:frees[%lu]\n", __FILE__, __LINE__, stat.frees);
+
     ret = papyruskv_close(db);
     if (ret != PAPYRUSKV_OK) printf("[%s:%d] ret[%d]\n", __FILE__, __LINE__, ret);
 
@@ -0,0 +1,168 @@
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <papyrus/kv.h>
+#include <papyrus/mpi.h>
+#include <unistd.h>
+#include <dirent.h>
+
+#define NKEYS   256
+#define NROUNDS 8
+
+int rank, size;
+char name[256];
+int db;
+int ret;
+
+/* 1: put, -1: delete, 0: untouched */
+int action(int i, int round) {
+    if (round == 0) return 1;
+    if (i % NROUNDS == round) return -1;
+    if (i % NROUNDS == 0 && round == NROUNDS - 1) return 1;
+    return i % 2 ? 1 : 0;
+}
+
+/* tables of this rank that are still on disk */
+int tables() {
+    char path[256];
+    char prefix[64];
+    sprintf(path, "kv_repo/%d", rank);
+    sprintf(prefix, "TEST_DB_%d_", rank);
+    DIR* dir = opendir(path);
+    if (dir == NULL) return -1;
+    int n = 0;
+    struct dirent* ent;
+    while ((ent = readdir(dir)) != NULL) {
+        size_t len = strlen(ent->d_name);
+        if (strncmp(ent->d_name, prefix, strlen(prefix)) == 0 && len > 4 && strcmp(ent->d_name + len - 4, ".sst") == 0) n++;
+    }
+    closedir(dir);
+    return n;
+}
+
+void put_all(int round) {
+    char key[64];
+    char val[64];
+    for (int i = 0; i < NKEYS; i++) {
+        sprintf(key, "KEY_%d_%d", rank, i);
+        sprintf(val, "VAL_%d_%d_%d", rank, i, round);
+        ret = papyruskv_put(db, key, strlen(key) + 1, val, strlen(val) + 1);
+        if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+    }
+    ret = papyruskv_barrier(db, PAPYRUSKV_SSTABLE);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+}
+
+int main(int argc, char** argv) {
+    setenv("PAPYRUSKV_MEMTABLE_SIZE", "4096", 0);
+    setenv("PAPYRUSKV_COMPACTION_TRIGGER", "2", 0);
+
+    MPI_Init(&argc, &argv);
+    papyruskv_init(&argc, &argv, "kv_repo");
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    MPI_Get_processor_name(name, &ret);
+
+    printf("[%s:%d] [%s] [%d/%d]\n", __FILE__, __LINE__, name, rank, size);
+
+    ret = papyruskv_open("TEST_DB", PAPYRUSKV_CREATE | PAPYRUSKV_RELAXED | PAPYRUSKV_RDWR, NULL, &db);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+
+    char key[64];
+    char val[64];
+
+    for (int round = 0; round < NROUNDS; round++) {
+        for (int i = 0; i < NKEYS; i++) {
+            sprintf(key, "KEY_%d_%d", rank, i);
+            int op = action(i, round);
+            if (op == 0) continue;
+            if (op < 0) ret = papyruskv_delete(db, key, strlen(key) + 1);
+            else {
+                sprintf(val, "VAL_%d_%d_%d", rank, i, round);
+                ret = papyruskv_put(db, key, strlen(key) + 1, val, strlen(val) + 1);
+            }
+            if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+        }
+        ret = papyruskv_barrier(db, PAPYRUSKV_SSTABLE);
+        if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+    }
+    printf("[%s:%d] PUT:rank[%d] keys[%d] rounds[%d]\n", __FILE__, __LINE__, rank, NKEYS, NROUNDS);
+
+    for (int r = 0; r < size; r++) {
+        int peer = (rank + r) % size;
+        int found = 0;
+        for (int i = 0; i < NKEYS; i++) {
+            int last = -1;
+            for (int round = 0; round < NROUNDS; round++) {
+                int op = action(i, round);
+                if (op > 0) last = round;
+                else if (op < 0) last = -1;
+            }
+
+            char* v = NULL;
+            size_t vallen = 0UL;
+            sprintf(key, "KEY_%d_%d", peer, i);
+            ret = papyruskv_get(db, key, strlen(key) + 1, &v, &vallen);
+            if (last == -1) {
+                if (ret == PAPYRUSKV_OK) printf("[%s:%d] FAILED:key[%s] val[%s] deleted\n", __FILE__, __LINE__, key, v);
+                continue;
+            }
+            sprintf(val, "VAL_%d_%d_%d", peer, i, last);
+            if (ret != PAPYRUSKV_OK || strcmp(v, val) != 0) {
+                printf("[%s:%d] FAILED:key[%s] ret[%d] val[%s] expected[%s]\n", __FILE__, __LINE__, key, ret, ret == PAPYRUSKV_OK ? v : "", val);
+                continue;
+            }
+            papyruskv_free(&v);
+            found++;
+        }
+        printf("[%s:%d] GET:rank[%d] peer[%d] found[%d]\n", __FILE__, __LINE__, rank, peer, found);
+    }
+
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    /* an abandoned iterator holds compaction off only until it is freed */
+    papyruskv_iter_t iter = NULL;
+    ret = papyruskv_iter_local(db, &iter);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+    for (int i = 0; iter && i < 8; i++) papyruskv_iter_next(db, &iter);
+    if (iter == NULL) printf("[%s:%d] FAILED:iter ended early\n", __FILE__, __LINE__);
+
+    for (int round = NROUNDS; round < 2 * NROUNDS; round++) put_all(round);
+    int pinned = tables();
+
+    ret = papyruskv_iter_free(db, &iter);
+    if (ret != PAPYRUSKV_OK || iter != NULL) printf("[%s:%d] FAILED:ret[%d] iter[%p]\n", __FILE__, __LINE__, ret, iter);
+
+    /* the next flush compacts the tables that piled up behind the iterator */
+    put_all(2 * NROUNDS);
+    int unpinned = tables();
+    for (int i = 0; i < 100 && unpinned >= pinned; i++) {
+        usleep(100000);
+        unpinned = tables();
+    }
+    printf("[%s:%d] ITER:rank[%d] pinned[%d] unpinned[%d]\n", __FILE__, __LINE__, rank, pinned, unpinned);
+    if (unpinned >= pinned) printf("[%s:%d] FAILED:pinned[%d] unpinned[%d]\n", __FILE__, __LINE__, pinned, unpinned);
+
+    for (int r = 0; r < size; r++) {
+        int peer = (rank + r) % size;
+        for (int i = 0; i < NKEYS; i++) {
+            char* v = NULL;
+            size_t vallen = 0UL;
+            sprintf(key, "KEY_%d_%d", peer, i);
+            sprintf(val, "VAL_%d_%d_%d", peer, i, 2 * NROUNDS);
+            ret = papyruskv_get(db, key, strlen(key) + 1, &v, &vallen);
+            if (ret != PAPYRUSKV_OK || strcmp(v, val) != 0)
+                printf("[%s:%d] FAILED:key[%s] ret[%d] val[%s] expected[%s]\n", __FILE__, __LINE__, key, ret, ret == PAPYRUSKV_OK ? v : "", val);
+            if (v) papyruskv_free(&v);
+        }
+    }
+
+    ret = papyruskv_close(db);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+
+    papyruskv_finalize();
+    MPI_Finalize();
+    return 0;
+}
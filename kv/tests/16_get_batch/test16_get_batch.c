@@ -0,0 +1,124 @@
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <papyrus/kv.h>
+#include <papyrus/mpi.h>
+#include <unistd.h>
+
+#define NKEYS   512
+
+int rank, size;
+char name[256];
+int db;
+int ret;
+
+const char* keys[NKEYS];
+size_t keylens[NKEYS];
+char* vals[NKEYS];
+size_t vallens[NKEYS];
+int rets[NKEYS];
+
+/* even keys are flushed to sstables, odd keys stay in memtables, every 8th key is never put */
+int check(int n, int tag) {
+    int found = 0;
+    char val[64];
+    ret = papyruskv_get_batch(db, n, keys, keylens, vals, vallens, rets);
+    for (int i = 0; i < n; i++) {
+        int peer = i % size;
+        int k = i / size;
+        if (k % 8 == 7) {
+            if (rets[i] == PAPYRUSKV_OK) printf("[%s:%d] FAILED:tag[%d] key[%s] val[%s] not put\n", __FILE__, __LINE__, tag, keys[i], vals[i]);
+            continue;
+        }
+        sprintf(val, "VAL_%d_%d", peer, k);
+        if (rets[i] != PAPYRUSKV_OK || strcmp(vals[i], val) != 0 || vallens[i] != strlen(val) + 1) {
+            printf("[%s:%d] FAILED:tag[%d] key[%s] ret[%d] expected[%s]\n", __FILE__, __LINE__, tag, keys[i], rets[i], val);
+            continue;
+        }
+        found++;
+    }
+    if (ret != PAPYRUSKV_ERR) printf("[%s:%d] FAILED:tag[%d] ret[%d]\n", __FILE__, __LINE__, tag, ret);
+    return found;
+}
+
+int main(int argc, char** argv) {
+    MPI_Init(&argc, &argv);
+    papyruskv_init(&argc, &argv, "kv_repo");
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    MPI_Get_processor_name(name, &ret);
+
+    printf("[%s:%d] [%s] [%d/%d]\n", __FILE__, __LINE__, name, rank, size);
+
+    ret = papyruskv_open("TEST_DB", PAPYRUSKV_CREATE | PAPYRUSKV_RELAXED | PAPYRUSKV_RDWR, NULL, &db);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+
+    char key[64];
+    char val[64];
+
+    for (int i = 0; i < NKEYS; i += 2) {
+        if (i % 8 == 7) continue;
+        sprintf(key, "KEY_%d_%d", rank, i);
+        sprintf(val, "VAL_%d_%d", rank, i);
+        ret = papyruskv_put(db, key, strlen(key) + 1, val, strlen(val) + 1);
+        if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+    }
+    ret = papyruskv_barrier(db, PAPYRUSKV_SSTABLE);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+
+    for (int i = 1; i < NKEYS; i += 2) {
+        if (i % 8 == 7) continue;
+        sprintf(key, "KEY_%d_%d", rank, i);
+        sprintf(val, "VAL_%d_%d", rank, i);
+        ret = papyruskv_put(db, key, strlen(key) + 1, val, strlen(val) + 1);
+        if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+    }
+    ret = papyruskv_barrier(db, PAPYRUSKV_MEMTABLE);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+
+    /* keys of all ranks interleaved in one batch */
+    int n = 0;
+    for (int k = 0; n < NKEYS; k++) {
+        for (int peer = 0; peer < size && n < NKEYS; peer++) {
+            char* s = (char*) malloc(64);
+            sprintf(s, "KEY_%d_%d", peer, k);
+            keys[n] = s;
+            keylens[n] = strlen(s) + 1;
+            n++;
+        }
+    }
+
+    for (int i = 0; i < n; i++) vals[i] = NULL;
+    int found = check(n, 0);
+    printf("[%s:%d] GET_BATCH:rank[%d] n[%d] found[%d]\n", __FILE__, __LINE__, rank, n, found);
+    for (int i = 0; i < n; i++) if (vals[i]) papyruskv_free(vals + i);
+
+    /* caller-provided value buffers */
+    for (int i = 0; i < n; i++) vals[i] = (char*) malloc(64);
+    found = check(n, 1);
+    printf("[%s:%d] GET_BATCH:rank[%d] n[%d] found[%d] preallocated\n", __FILE__, __LINE__, rank, n, found);
+    for (int i = 0; i < n; i++) free(vals[i]);
+
+    /* read-only protection serves repeated lookups from the remote cache */
+    ret = papyruskv_protect(db, PAPYRUSKV_RDONLY);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+    for (int t = 2; t < 4; t++) {
+        for (int i = 0; i < n; i++) vals[i] = NULL;
+        found = check(n, t);
+        printf("[%s:%d] GET_BATCH:rank[%d] n[%d] found[%d] rdonly\n", __FILE__, __LINE__, rank, n, found);
+        for (int i = 0; i < n; i++) if (vals[i]) papyruskv_free(vals + i);
+    }
+    ret = papyruskv_protect(db, PAPYRUSKV_RDWR);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+
+    for (int i = 0; i < n; i++) free((char*) keys[i]);
+
+    ret = papyruskv_close(db);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+
+    papyruskv_finalize();
+    MPI_Finalize();
+    return 0;
+}
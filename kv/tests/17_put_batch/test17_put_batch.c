@@ -0,0 +1,112 @@
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <papyrus/kv.h>
+#include <papyrus/mpi.h>
+#include <unistd.h>
+
+#define NKEYS   1024
+
+int rank, size;
+char name[256];
+int db;
+int ret;
+
+const char* keys[NKEYS];
+size_t keylens[NKEYS];
+const char* vals[NKEYS];
+size_t vallens[NKEYS];
+
+void fill(int round) {
+    for (int i = 0; i < NKEYS; i++) {
+        char* v = (char*) vals[i];
+        sprintf(v, "VAL_%d_%d_%d", rank, i, round);
+        vallens[i] = strlen(v) + 1;
+    }
+}
+
+int check(int round) {
+    int found = 0;
+    char key[64];
+    char val[64];
+    for (int r = 0; r < size; r++) {
+        int peer = (rank + r) % size;
+        for (int i = 0; i < NKEYS; i++) {
+            char* v = NULL;
+            size_t vallen = 0UL;
+            sprintf(key, "KEY_%d_%d", peer, i);
+            sprintf(val, "VAL_%d_%d_%d", peer, i, round);
+            ret = papyruskv_get(db, key, strlen(key) + 1, &v, &vallen);
+            if (ret != PAPYRUSKV_OK || strcmp(v, val) != 0) {
+                printf("[%s:%d] FAILED:round[%d] key[%s] ret[%d] val[%s] expected[%s]\n", __FILE__, __LINE__, round, key, ret, ret == PAPYRUSKV_OK ? v : "", val);
+                continue;
+            }
+            papyruskv_free(&v);
+            found++;
+        }
+    }
+    return found;
+}
+
+int main(int argc, char** argv) {
+    MPI_Init(&argc, &argv);
+    papyruskv_init(&argc, &argv, "kv_repo");
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    MPI_Get_processor_name(name, &ret);
+
+    printf("[%s:%d] [%s] [%d/%d]\n", __FILE__, __LINE__, name, rank, size);
+
+    ret = papyruskv_open("TEST_DB", PAPYRUSKV_CREATE | PAPYRUSKV_RELAXED | PAPYRUSKV_RDWR, NULL, &db);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+
+    for (int i = 0; i < NKEYS; i++) {
+        char* k = (char*) malloc(64);
+        sprintf(k, "KEY_%d_%d", rank, i);
+        keys[i] = k;
+        keylens[i] = strlen(k) + 1;
+        vals[i] = (char*) malloc(64);
+    }
+
+    /* round 0: single puts still buffered must not overwrite the batch of round 1 */
+    fill(0);
+    for (int i = 0; i < NKEYS; i++) {
+        ret = papyruskv_put(db, keys[i], keylens[i], vals[i], vallens[i]);
+        if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+    }
+    fill(1);
+    ret = papyruskv_put_batch(db, NKEYS, keys, keylens, vals, vallens);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+
+    ret = papyruskv_barrier(db, PAPYRUSKV_MEMTABLE);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+    printf("[%s:%d] RELAXED:rank[%d] found[%d]\n", __FILE__, __LINE__, rank, check(1));
+
+    ret = papyruskv_barrier(db, PAPYRUSKV_SSTABLE);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+
+    /* round 2: sequential batches are visible once every rank has returned */
+    ret = papyruskv_consistency(db, PAPYRUSKV_SEQUENTIAL);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+    fill(2);
+    ret = papyruskv_put_batch(db, NKEYS, keys, keylens, vals, vallens);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+    MPI_Barrier(MPI_COMM_WORLD);
+    printf("[%s:%d] SEQUENTIAL:rank[%d] found[%d]\n", __FILE__, __LINE__, rank, check(2));
+
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    for (int i = 0; i < NKEYS; i++) {
+        free((char*) keys[i]);
+        free((char*) vals[i]);
+    }
+
+    ret = papyruskv_close(db);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+
+    papyruskv_finalize();
+    MPI_Finalize();
+    return 0;
+}
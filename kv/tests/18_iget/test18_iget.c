@@ -0,0 +1,97 @@
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <papyrus/kv.h>
+#include <papyrus/mpi.h>
+#include <unistd.h>
+
+#define NKEYS   256
+
+int rank, size;
+char name[256];
+int db;
+int ret;
+
+int main(int argc, char** argv) {
+    MPI_Init(&argc, &argv);
+    papyruskv_init(&argc, &argv, "kv_repo");
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    MPI_Get_processor_name(name, &ret);
+
+    printf("[%s:%d] [%s] [%d/%d]\n", __FILE__, __LINE__, name, rank, size);
+
+    ret = papyruskv_open("TEST_DB", PAPYRUSKV_CREATE | PAPYRUSKV_RELAXED | PAPYRUSKV_RDWR, NULL, &db);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+
+    char key[64];
+    char val[64];
+
+    /* the first half of the keys is flushed to sstables, every 4th key is never put */
+    for (int i = 0; i < NKEYS; i++) {
+        if (i % 4 == 3) continue;
+        sprintf(key, "KEY_%d_%d", rank, i);
+        sprintf(val, "VAL_%d_%d", rank, i);
+        ret = papyruskv_put(db, key, strlen(key) + 1, val, strlen(val) + 1);
+        if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+        if (i == NKEYS / 2) {
+            ret = papyruskv_barrier(db, PAPYRUSKV_SSTABLE);
+            if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+        }
+    }
+    ret = papyruskv_barrier(db, PAPYRUSKV_MEMTABLE);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+
+    int n = NKEYS * size;
+    int* events = (int*) malloc(n * sizeof(int));
+    char** vals = (char**) malloc(n * sizeof(char*));
+    size_t* vallens = (size_t*) malloc(n * sizeof(size_t));
+
+    /* all gets are outstanding before any of them is waited on */
+    for (int j = 0; j < n; j++) {
+        int peer = (rank + j) % size;
+        int i = j / size;
+        sprintf(key, "KEY_%d_%d", peer, i);
+        vals[j] = NULL;
+        ret = papyruskv_iget(db, key, strlen(key) + 1, vals + j, vallens + j, events + j);
+        if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+    }
+
+    int found = 0;
+    int tested = 0;
+    for (int j = 0; j < n; j++) {
+        int peer = (rank + j) % size;
+        int i = j / size;
+        int flag = 0;
+        if (j % 2) {
+            ret = papyruskv_test(db, events[j], &flag);
+            if (flag) tested++;
+        }
+        if (!flag) ret = papyruskv_wait(db, events[j]);
+        if (i % 4 == 3) {
+            if (ret == PAPYRUSKV_OK) printf("[%s:%d] FAILED:key[KEY_%d_%d] val[%s] not put\n", __FILE__, __LINE__, peer, i, vals[j]);
+            continue;
+        }
+        sprintf(val, "VAL_%d_%d", peer, i);
+        if (ret != PAPYRUSKV_OK || strcmp(vals[j], val) != 0 || vallens[j] != strlen(val) + 1) {
+            printf("[%s:%d] FAILED:key[KEY_%d_%d] ret[%d] expected[%s]\n", __FILE__, __LINE__, peer, i, ret, val);
+            continue;
+        }
+        papyruskv_free(vals + j);
+        found++;
+    }
+    printf("[%s:%d] IGET:rank[%d] n[%d] found[%d] tested[%d]\n", __FILE__, __LINE__, rank, n, found, tested);
+
+    free(events);
+    free(vals);
+    free(vallens);
+
+    ret = papyruskv_close(db);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+
+    papyruskv_finalize();
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,114 @@
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <papyrus/kv.h>
+#include <papyrus/mpi.h>
+#include <unistd.h>
+
+#define NKEYS   256
+
+int rank, size;
+char name[256];
+int db;
+int ret;
+
+int main(int argc, char** argv) {
+    MPI_Init(&argc, &argv);
+    papyruskv_init(&argc, &argv, "kv_repo");
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    MPI_Get_processor_name(name, &ret);
+
+    printf("[%s:%d] [%s] [%d/%d]\n", __FILE__, __LINE__, name, rank, size);
+
+    ret = papyruskv_open("TEST_DB", PAPYRUSKV_CREATE | PAPYRUSKV_RELAXED | PAPYRUSKV_RDWR, NULL, &db);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+
+    char key[64];
+    char val[64];
+
+    /* the first half of the keys is flushed to sstables, every 4th key is never put */
+    for (int i = 0; i < NKEYS; i++) {
+        if (i % 4 == 3) continue;
+        sprintf(key, "KEY_%d_%d", rank, i);
+        sprintf(val, "VAL_%d_%d", rank, i);
+        ret = papyruskv_put(db, key, strlen(key) + 1, val, strlen(val) + 1);
+        if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+        if (i == NKEYS / 2) {
+            ret = papyruskv_barrier(db, PAPYRUSKV_SSTABLE);
+            if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+        }
+    }
+    ret = papyruskv_barrier(db, PAPYRUSKV_MEMTABLE);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+
+    int n = NKEYS * size;
+    const char** vals = (const char**) malloc(n * sizeof(char*));
+    size_t* vallens = (size_t*) malloc(n * sizeof(size_t));
+    papyruskv_view_t* views = (papyruskv_view_t*) malloc(n * sizeof(papyruskv_view_t));
+
+    for (int j = 0; j < n; j++) {
+        int peer = (rank + j) % size;
+        int i = j / size;
+        sprintf(key, "KEY_%d_%d", peer, i);
+        ret = papyruskv_get_view(db, key, strlen(key) + 1, vals + j, vallens + j, views + j);
+        if (i % 4 == 3) {
+            if (ret == PAPYRUSKV_OK || views[j] != NULL) printf("[%s:%d] FAILED:key[%s] not put\n", __FILE__, __LINE__, key);
+            continue;
+        }
+        if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:key[%s] ret[%d]\n", __FILE__, __LINE__, key, ret);
+    }
+
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    /* overwrite and flush every local key while the views are still held */
+    for (int i = 0; i < NKEYS; i++) {
+        if (i % 4 == 3) continue;
+        sprintf(key, "KEY_%d_%d", rank, i);
+        sprintf(val, "NEW_%d_%d", rank, i);
+        ret = papyruskv_put(db, key, strlen(key) + 1, val, strlen(val) + 1);
+        if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+    }
+    ret = papyruskv_barrier(db, PAPYRUSKV_SSTABLE);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+
+    int found = 0;
+    for (int j = 0; j < n; j++) {
+        int peer = (rank + j) % size;
+        int i = j / size;
+        if (i % 4 == 3) continue;
+        sprintf(val, "VAL_%d_%d", peer, i);
+        if (vals[j] == NULL || strcmp(vals[j], val) != 0 || vallens[j] != strlen(val) + 1)
+            printf("[%s:%d] FAILED:key[KEY_%d_%d] val[%s] expected[%s]\n", __FILE__, __LINE__, peer, i, vals[j], val);
+        else found++;
+        ret = papyruskv_release_view(db, views[j]);
+        if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+    }
+    printf("[%s:%d] VIEW:rank[%d] n[%d] found[%d]\n", __FILE__, __LINE__, rank, n, found);
+
+    for (int i = 0; i < NKEYS; i++) {
+        if (i % 4 == 3) continue;
+        sprintf(key, "KEY_%d_%d", rank, i);
+        sprintf(val, "NEW_%d_%d", rank, i);
+        const char* v = NULL;
+        size_t vallen = 0UL;
+        papyruskv_view_t view;
+        ret = papyruskv_get_view(db, key, strlen(key) + 1, &v, &vallen, &view);
+        if (ret != PAPYRUSKV_OK || strcmp(v, val) != 0 || vallen != strlen(val) + 1)
+            printf("[%s:%d] FAILED:key[%s] ret[%d] expected[%s]\n", __FILE__, __LINE__, key, ret, val);
+        if (ret == PAPYRUSKV_OK) papyruskv_release_view(db, view);
+    }
+
+    free(vals);
+    free(vallens);
+    free(views);
+
+    ret = papyruskv_close(db);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+
+    papyruskv_finalize();
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,96 @@
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <papyrus/kv.h>
+#include <papyrus/mpi.h>
+#include <unistd.h>
+
+#define NKEYS   512
+#define VALLEN  1024
+#define CACHE   (64 * 1024)
+
+int rank, size;
+char name[256];
+int db;
+int ret;
+
+int hash(const char* key, size_t keylen, size_t nranks) {
+    return atoi(key + 4) % nranks;
+}
+
+int main(int argc, char** argv) {
+    /* a cache much smaller than the data set, so eviction has to keep up */
+    setenv("PAPYRUSKV_CACHE_LOCAL", "1", 0);
+    setenv("PAPYRUSKV_CACHE_SIZE", "65536", 0);
+
+    MPI_Init(&argc, &argv);
+    papyruskv_init(&argc, &argv, "kv_repo");
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    MPI_Get_processor_name(name, &ret);
+
+    printf("[%s:%d] [%s] [%d/%d]\n", __FILE__, __LINE__, name, rank, size);
+
+    papyruskv_option_t opt = { 0, 0, hash };
+    ret = papyruskv_open("TEST_DB", PAPYRUSKV_CREATE | PAPYRUSKV_RELAXED | PAPYRUSKV_RDWR, &opt, &db);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+
+    char key[64];
+    char val[VALLEN];
+    memset(val, 'a' + rank, sizeof(val));
+    val[VALLEN - 1] = 0;
+
+    for (int i = 0; i < NKEYS; i++) {
+        sprintf(key, "KEY_%d", i * size + rank);
+        ret = papyruskv_put(db, key, strlen(key) + 1, val, VALLEN);
+        if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+    }
+    ret = papyruskv_barrier(db, PAPYRUSKV_SSTABLE);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+
+    /* every local get misses the cache once and fills it from the sstable */
+    for (int i = 0; i < NKEYS; i++) {
+        sprintf(key, "KEY_%d", i * size + rank);
+        char* v = NULL;
+        size_t vallen = 0UL;
+        ret = papyruskv_get(db, key, strlen(key) + 1, &v, &vallen);
+        if (ret != PAPYRUSKV_OK || vallen != VALLEN || strcmp(v, val) != 0) printf("[%s:%d] FAILED:key[%s] ret[%d]\n", __FILE__, __LINE__, key, ret);
+        if (v) papyruskv_free(&v);
+    }
+
+    papyruskv_cache_stat_t stat;
+    ret = papyruskv_cache_stat(db, &stat, NULL);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+    printf("[%s:%d] STAT:rank[%d] capacity[%lu] bytes[%lu] entries[%lu] hits[%lu] misses[%lu] evicted[%lu]\n", __FILE__, __LINE__, rank, stat.capacity, stat.bytes, stat.entries, stat.hits, stat.misses, stat.evicted);
+    if (stat.capacity != CACHE || stat.bytes > stat.capacity) printf("[%s:%d] FAILED:capacity[%lu] bytes[%lu]\n", __FILE__, __LINE__, stat.capacity, stat.bytes);
+    if (stat.entries == 0 || stat.entries * VALLEN > stat.bytes) printf("[%s:%d] FAILED:entries[%lu] bytes[%lu]\n", __FILE__, __LINE__, stat.entries, stat.bytes);
+    if (stat.misses != NKEYS || stat.hits != 0) printf("[%s:%d] FAILED:hits[%lu] misses[%lu]\n", __FILE__, __LINE__, stat.hits, stat.misses);
+    if (stat.entries + stat.evicted != NKEYS) printf("[%s:%d] FAILED:entries[%lu] evicted[%lu]\n", __FILE__, __LINE__, stat.entries, stat.evicted);
+
+    /* the most recent key is still resident */
+    sprintf(key, "KEY_%d", (NKEYS - 1) * size + rank);
+    char* v = NULL;
+    size_t vallen = 0UL;
+    ret = papyruskv_get(db, key, strlen(key) + 1, &v, &vallen);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:key[%s] ret[%d]\n", __FILE__, __LINE__, key, ret);
+    if (v) papyruskv_free(&v);
+    ret = papyruskv_cache_stat(db, &stat, NULL);
+    if (stat.hits != 1) printf("[%s:%d] FAILED:hits[%lu]\n", __FILE__, __LINE__, stat.hits);
+
+    /* leaving write-only protection drops the whole local cache */
+    ret = papyruskv_protect(db, PAPYRUSKV_WRONLY);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+    ret = papyruskv_protect(db, PAPYRUSKV_RDWR);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+    ret = papyruskv_cache_stat(db, &stat, NULL);
+    if (stat.bytes != 0 || stat.entries != 0) printf("[%s:%d] FAILED:bytes[%lu] entries[%lu]\n", __FILE__, __LINE__, stat.bytes, stat.entries);
+
+    ret = papyruskv_close(db);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+
+    papyruskv_finalize();
+    MPI_Finalize();
+    return 0;
+}
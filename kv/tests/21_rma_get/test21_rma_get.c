@@ -0,0 +1,110 @@
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <papyrus/kv.h>
+#include <papyrus/mpi.h>
+#include <unistd.h>
+
+#define NKEYS   256
+#define VALLEN  64
+#define BIGLEN  4000
+
+int rank, size;
+char name[256];
+int db;
+int ret;
+
+static void check(const char* key, const char* expect, size_t expectlen) {
+    char* v = NULL;
+    size_t vallen = 0UL;
+    ret = papyruskv_get(db, key, strlen(key) + 1, &v, &vallen);
+    if (expect == NULL) {
+        if (ret == PAPYRUSKV_OK) printf("[%s:%d] FAILED:key[%s] ret[%d]\n", __FILE__, __LINE__, key, ret);
+    } else if (ret != PAPYRUSKV_OK || vallen != expectlen || memcmp(v, expect, expectlen) != 0)
+        printf("[%s:%d] FAILED:key[%s] ret[%d] vallen[%lu]\n", __FILE__, __LINE__, key, ret, vallen);
+    if (v) papyruskv_free(&v);
+}
+
+int main(int argc, char** argv) {
+    /* remote gets of a hashed read-only table go through MPI_Get */
+    setenv("PAPYRUSKV_RMA", "1", 0);
+
+    MPI_Init(&argc, &argv);
+    papyruskv_init(&argc, &argv, "kv_repo");
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    MPI_Get_processor_name(name, &ret);
+
+    printf("[%s:%d] [%s] [%d/%d]\n", __FILE__, __LINE__, name, rank, size);
+
+    ret = papyruskv_open("TEST_DB", PAPYRUSKV_CREATE | PAPYRUSKV_RELAXED | PAPYRUSKV_RDWR, NULL, &db);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+
+    char key[64];
+    char val[VALLEN];
+    char big[BIGLEN];
+    for (int i = 0; i < NKEYS; i++) {
+        sprintf(key, "KEY_%d_%d", rank, i);
+        sprintf(val, "VAL_%d_%d", rank, i);
+        ret = papyruskv_put(db, key, strlen(key) + 1, val, strlen(val) + 1);
+        if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+    }
+    /* larger than what one read of an entry brings back */
+    memset(big, 'a' + rank, BIGLEN);
+    sprintf(key, "BIG_%d", rank);
+    ret = papyruskv_put(db, key, strlen(key) + 1, big, BIGLEN);
+    sprintf(key, "DEL_%d", rank);
+    ret = papyruskv_put(db, key, strlen(key) + 1, big, 16);
+    ret = papyruskv_delete(db, key, strlen(key) + 1);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+
+    ret = papyruskv_protect(db, PAPYRUSKV_RDONLY);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+    ret = papyruskv_hash(db, NULL);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    for (int r = 0; r < size; r++) {
+        for (int i = 0; i < NKEYS; i++) {
+            sprintf(key, "KEY_%d_%d", r, i);
+            sprintf(val, "VAL_%d_%d", r, i);
+            check(key, val, strlen(val) + 1);
+        }
+        memset(big, 'a' + r, BIGLEN);
+        sprintf(key, "BIG_%d", r);
+        check(key, big, BIGLEN);
+        sprintf(key, "DEL_%d", r);
+        check(key, NULL, 0);
+        sprintf(key, "NONE_%d", r);
+        check(key, NULL, 0);
+    }
+
+    /* a new read-only phase exposes the updated table */
+    ret = papyruskv_protect(db, PAPYRUSKV_RDWR);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+    sprintf(key, "KEY_%d_0", rank);
+    ret = papyruskv_put(db, key, strlen(key) + 1, "NEW", 4);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+    ret = papyruskv_protect(db, PAPYRUSKV_RDONLY);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+    ret = papyruskv_hash(db, NULL);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    for (int r = 0; r < size; r++) {
+        sprintf(key, "KEY_%d_0", r);
+        check(key, "NEW", 4);
+        sprintf(key, "KEY_%d_1", r);
+        sprintf(val, "VAL_%d_1", r);
+        check(key, val, strlen(val) + 1);
+    }
+
+    ret = papyruskv_close(db);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+
+    papyruskv_finalize();
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,94 @@
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <papyrus/kv.h>
+#include <papyrus/mpi.h>
+#include <unistd.h>
+
+#define NDBS    3
+#define NKEYS   512
+#define BIGLEN  (3 * 1024 * 1024 + 17)
+
+int rank, size;
+char name[256];
+int dbs[NDBS];
+int ret;
+
+int main(int argc, char** argv) {
+    /* small memtables keep several flushes of different DBs in flight */
+    setenv("PAPYRUSKV_FLUSH_THREADS", "2", 0);
+    setenv("PAPYRUSKV_DIRECT_IO", "1", 0);
+    setenv("PAPYRUSKV_MEMTABLE_SIZE", "65536", 0);
+
+    MPI_Init(&argc, &argv);
+    papyruskv_init(&argc, &argv, "kv_repo");
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    MPI_Get_processor_name(name, &ret);
+
+    printf("[%s:%d] [%s] [%d/%d]\n", __FILE__, __LINE__, name, rank, size);
+
+    char dbname[64];
+    for (int d = 0; d < NDBS; d++) {
+        sprintf(dbname, "TEST_DB_%d", d);
+        ret = papyruskv_open(dbname, PAPYRUSKV_CREATE | PAPYRUSKV_RELAXED | PAPYRUSKV_RDWR, NULL, dbs + d);
+        if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+    }
+
+    char key[64];
+    char val[64];
+    for (int i = 0; i < NKEYS; i++) {
+        for (int d = 0; d < NDBS; d++) {
+            sprintf(key, "KEY_%d_%d", rank, i);
+            sprintf(val, "VAL_%d_%d_%d", d, rank, i);
+            ret = papyruskv_put(dbs[d], key, strlen(key) + 1, val, strlen(val) + 1);
+            if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+        }
+    }
+    /* spans several table buffers */
+    char* big = (char*) malloc(BIGLEN);
+    for (size_t i = 0; i < BIGLEN; i++) big[i] = (char) (i * 7 + rank);
+    sprintf(key, "BIG_%d", rank);
+    ret = papyruskv_put(dbs[0], key, strlen(key) + 1, big, BIGLEN);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+
+    for (int d = 0; d < NDBS; d++) {
+        ret = papyruskv_barrier(dbs[d], PAPYRUSKV_SSTABLE);
+        if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+    }
+
+    for (int r = 0; r < size; r++) {
+        for (int i = 0; i < NKEYS; i++) {
+            for (int d = 0; d < NDBS; d++) {
+                char* v = NULL;
+                size_t vallen = 0UL;
+                sprintf(key, "KEY_%d_%d", r, i);
+                sprintf(val, "VAL_%d_%d_%d", d, r, i);
+                ret = papyruskv_get(dbs[d], key, strlen(key) + 1, &v, &vallen);
+                if (ret != PAPYRUSKV_OK || vallen != strlen(val) + 1 || strcmp(v, val) != 0)
+                    printf("[%s:%d] FAILED:key[%s] ret[%d] vallen[%lu]\n", __FILE__, __LINE__, key, ret, vallen);
+                if (v) papyruskv_free(&v);
+            }
+        }
+        char* v = NULL;
+        size_t vallen = 0UL;
+        for (size_t i = 0; i < BIGLEN; i++) big[i] = (char) (i * 7 + r);
+        sprintf(key, "BIG_%d", r);
+        ret = papyruskv_get(dbs[0], key, strlen(key) + 1, &v, &vallen);
+        if (ret != PAPYRUSKV_OK || vallen != BIGLEN || memcmp(v, big, BIGLEN) != 0)
+            printf("[%s:%d] FAILED:key[%s] ret[%d] vallen[%lu]\n", __FILE__, __LINE__, key, ret, vallen);
+        if (v) papyruskv_free(&v);
+    }
+    free(big);
+
+    for (int d = 0; d < NDBS; d++) {
+        ret = papyruskv_close(dbs[d]);
+        if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+    }
+
+    papyruskv_finalize();
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,91 @@
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <papyrus/kv.h>
+#include <papyrus/mpi.h>
+#include <unistd.h>
+
+#define NKEYS   256
+#define NROUNDS 8
+
+int rank, size;
+char name[256];
+int db;
+int ret;
+
+int hash(const char* key, size_t keylen, size_t nranks) {
+    return atoi(key + 4) % nranks;
+}
+
+int main(int argc, char** argv) {
+    /* pairs of ranks share storage, so a peer in the group reads the owner's
+     * tables itself, and every flush compacts behind the readers' backs.
+     * Without a table cache each read reopens its tables, so a reader that
+     * loses the race with a compaction has to retry through the owner. */
+    setenv("PAPYRUSKV_GROUP_SIZE", "2", 0);
+    setenv("PAPYRUSKV_MEMTABLE_SIZE", "4096", 0);
+    setenv("PAPYRUSKV_COMPACTION_TRIGGER", "2", 0);
+    setenv("PAPYRUSKV_TABLE_CACHE_SIZE", "0", 0);
+
+    MPI_Init(&argc, &argv);
+    papyruskv_init(&argc, &argv, "kv_repo");
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    MPI_Get_processor_name(name, &ret);
+
+    printf("[%s:%d] [%s] [%d/%d]\n", __FILE__, __LINE__, name, rank, size);
+
+    papyruskv_option_t opt = { 0, 0, hash };
+    ret = papyruskv_open("TEST_DB", PAPYRUSKV_CREATE | PAPYRUSKV_RELAXED | PAPYRUSKV_RDWR, &opt, &db);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+
+    char key[64];
+    char val[64];
+
+    for (int round = 0; round < NROUNDS; round++) {
+        for (int i = 0; i < NKEYS; i++) {
+            sprintf(key, "KEY_%d", i * size + rank);
+            sprintf(val, "VAL_%d_%d", i * size + rank, round);
+            ret = papyruskv_put(db, key, strlen(key) + 1, val, strlen(val) + 1);
+            if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+        }
+        ret = papyruskv_barrier(db, PAPYRUSKV_SSTABLE);
+        if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+
+        /* rewriting the same values keeps every owner flushing and compacting
+         * while its group peer reads the tables directly */
+        for (int r = 1; r < size; r++) {
+            int peer = (rank + r) % size;
+            int found = 0;
+            for (int i = 0; i < NKEYS; i++) {
+                sprintf(key, "KEY_%d", i * size + rank);
+                sprintf(val, "VAL_%d_%d", i * size + rank, round);
+                ret = papyruskv_put(db, key, strlen(key) + 1, val, strlen(val) + 1);
+                if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+
+                char* v = NULL;
+                size_t vallen = 0UL;
+                sprintf(key, "KEY_%d", i * size + peer);
+                sprintf(val, "VAL_%d_%d", i * size + peer, round);
+                ret = papyruskv_get(db, key, strlen(key) + 1, &v, &vallen);
+                if (ret != PAPYRUSKV_OK || strcmp(v, val) != 0) {
+                    printf("[%s:%d] FAILED:key[%s] ret[%d] val[%s] expected[%s]\n", __FILE__, __LINE__, key, ret, ret == PAPYRUSKV_OK ? v : "", val);
+                    continue;
+                }
+                papyruskv_free(&v);
+                found++;
+            }
+            if (round == NROUNDS - 1) printf("[%s:%d] GET:rank[%d] peer[%d] found[%d]\n", __FILE__, __LINE__, rank, peer, found);
+        }
+        MPI_Barrier(MPI_COMM_WORLD);
+    }
+
+    ret = papyruskv_close(db);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+
+    papyruskv_finalize();
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,95 @@
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <papyrus/kv.h>
+#include <papyrus/mpi.h>
+#include <unistd.h>
+
+#define NKEYS   16
+
+int rank, size;
+char name[256];
+int db;
+int ret;
+
+int hash(const char* key, size_t keylen, size_t nranks) {
+    return atoi(key + 4) % nranks;
+}
+
+void get_all(int peer, const char* prefix) {
+    char key[64];
+    char val[64];
+    for (int i = 0; i < NKEYS; i++) {
+        char* v = NULL;
+        size_t vallen = 0UL;
+        sprintf(key, "KEY_%d", i * size + peer);
+        sprintf(val, "%s_%d", prefix, i * size + peer);
+        ret = papyruskv_get(db, key, strlen(key) + 1, &v, &vallen);
+        if (ret != PAPYRUSKV_OK || strcmp(v, val) != 0)
+            printf("[%s:%d] FAILED:rank[%d] key[%s] ret[%d] val[%s] expected[%s]\n", __FILE__, __LINE__, rank, key, ret, ret == PAPYRUSKV_OK ? v : "", val);
+        if (v) papyruskv_free(&v);
+    }
+}
+
+void put_all(const char* prefix) {
+    char key[64];
+    char val[64];
+    for (int i = 0; i < NKEYS; i++) {
+        sprintf(key, "KEY_%d", i * size + rank);
+        sprintf(val, "%s_%d", prefix, i * size + rank);
+        ret = papyruskv_put(db, key, strlen(key) + 1, val, strlen(val) + 1);
+        if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+    }
+}
+
+int main(int argc, char** argv) {
+    /* a lease far longer than the test, so only the barrier can invalidate */
+    setenv("PAPYRUSKV_CACHE_REMOTE", "1", 0);
+    setenv("PAPYRUSKV_CACHE_LEASE", "600000000", 0);
+
+    MPI_Init(&argc, &argv);
+    papyruskv_init(&argc, &argv, "kv_repo");
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    MPI_Get_processor_name(name, &ret);
+
+    printf("[%s:%d] [%s] [%d/%d]\n", __FILE__, __LINE__, name, rank, size);
+
+    papyruskv_option_t opt = { 0, 0, hash };
+    ret = papyruskv_open("TEST_DB", PAPYRUSKV_CREATE | PAPYRUSKV_RELAXED | PAPYRUSKV_RDWR, &opt, &db);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+
+    int peer = (rank + 1) % size;
+
+    put_all("OLD");
+    ret = papyruskv_barrier(db, PAPYRUSKV_MEMTABLE);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+
+    /* the first read fills the remote cache under RDWR, the second hits it */
+    get_all(peer, "OLD");
+    get_all(peer, "OLD");
+
+    papyruskv_cache_stat_t stat;
+    ret = papyruskv_cache_stat(db, NULL, &stat);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+    printf("[%s:%d] STAT:rank[%d] entries[%lu] hits[%lu] misses[%lu]\n", __FILE__, __LINE__, rank, stat.entries, stat.hits, stat.misses);
+    if (size > 1 && (stat.entries != NKEYS || stat.hits != NKEYS)) printf("[%s:%d] FAILED:entries[%lu] hits[%lu]\n", __FILE__, __LINE__, stat.entries, stat.hits);
+
+    /* every reader holds a leased copy before the owners overwrite */
+    MPI_Barrier(MPI_COMM_WORLD);
+    put_all("NEW");
+    ret = papyruskv_barrier(db, PAPYRUSKV_MEMTABLE);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+
+    /* the barrier exchanged the owners' epochs, so the leased copies are stale */
+    get_all(peer, "NEW");
+
+    ret = papyruskv_close(db);
+    if (ret != PAPYRUSKV_OK) printf("[%s:%d] FAILED:ret[%d]\n", __FILE__, __LINE__, ret);
+
+    papyruskv_finalize();
+    MPI_Finalize();
+    return 0;
+}